@@ -0,0 +1,166 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of AcquisitionReactor
+ */
+#include "glscopeclient.h"
+#include "AcquisitionReactor.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+extern map<Oscilloscope*, WaveformQueue*> g_waveformQueues;
+extern map<Oscilloscope*, BackpressurePolicy*> g_backpressurePolicies;
+
+//epoll user data for the stop event (poller indexes are used for the timers)
+#define STOP_EVENT_TAG	UINT64_MAX
+
+/**
+	@brief Creates the timers and starts the threads. Every instrument is polled right away.
+ */
+AcquisitionReactor::AcquisitionReactor(const vector<Oscilloscope*>& scopes, size_t nthreads)
+{
+	m_epoll = epoll_create1(EPOLL_CLOEXEC);
+	m_stopEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if( (m_epoll < 0) || (m_stopEvent < 0) )
+	{
+		LogError("Failed to create epoll instance for acquisition reactor\n");
+		exit(1);
+	}
+
+	//Level triggered and never consumed, so once signaled it wakes every thread
+	epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.u64 = STOP_EVENT_TAG;
+	epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_stopEvent, &ev);
+
+	for(size_t i=0; i<scopes.size(); i++)
+	{
+		int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		if(fd < 0)
+		{
+			LogError("Failed to create timer for acquisition reactor\n");
+			exit(1);
+		}
+		m_pollers.push_back(new ScopePoller(scopes[i], g_waveformQueues.at(scopes[i]), g_backpressurePolicies.at(scopes[i])));
+		m_timers.push_back(fd);
+
+		ev.events = EPOLLIN | EPOLLONESHOT;
+		ev.data.u64 = i;
+		epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev);
+		Arm(i, 0);
+	}
+
+	LogDebug("Acquisition reactor: %zu instruments on %zu threads\n", scopes.size(), nthreads);
+	for(size_t i=0; i<nthreads; i++)
+		m_threads.push_back(new thread(&AcquisitionReactor::ThreadProc, this));
+}
+
+AcquisitionReactor::~AcquisitionReactor()
+{
+	uint64_t one = 1;
+	if(write(m_stopEvent, &one, sizeof(one)) != sizeof(one))
+		LogError("Failed to signal acquisition reactor shutdown\n");
+
+	for(auto t : m_threads)
+	{
+		t->join();
+		delete t;
+	}
+
+	for(auto fd : m_timers)
+		close(fd);
+	for(auto p : m_pollers)
+		delete p;
+	close(m_stopEvent);
+	close(m_epoll);
+}
+
+/**
+	@brief Starts the timer for a poller. A delay of zero fires as soon as possible.
+ */
+void AcquisitionReactor::Arm(size_t i, uint32_t delay_us)
+{
+	//An all-zero it_value would disarm the timer, so use 1 ns instead
+	uint64_t ns = max((uint64_t)delay_us * 1000, (uint64_t)1);
+
+	itimerspec spec;
+	spec.it_interval.tv_sec = 0;
+	spec.it_interval.tv_nsec = 0;
+	spec.it_value.tv_sec = ns / 1000000000;
+	spec.it_value.tv_nsec = ns % 1000000000;
+	timerfd_settime(m_timers[i], 0, &spec, NULL);
+}
+
+void AcquisitionReactor::ThreadProc()
+{
+	#ifndef _WIN32
+	pthread_setname_np(pthread_self(), "AcqReactor");
+	#endif
+
+	while(true)
+	{
+		//Take one event at a time so other threads can pick up the rest
+		epoll_event ev;
+		int n = epoll_wait(m_epoll, &ev, 1, -1);
+		if(n < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			LogError("epoll_wait failed in acquisition reactor\n");
+			return;
+		}
+		if(n == 0)
+			continue;
+
+		if(ev.data.u64 == STOP_EVENT_TAG)
+			return;
+
+		//Consume the expiration
+		size_t i = ev.data.u64;
+		uint64_t expirations;
+		if(read(m_timers[i], &expirations, sizeof(expirations)) != sizeof(expirations))
+		{
+			//Spurious wakeup, nothing to consume
+		}
+
+		//Do one step of the state machine, then hand the instrument back to the pool
+		Arm(i, m_pollers[i]->Poll());
+
+		ev.events = EPOLLIN | EPOLLONESHOT;
+		ev.data.u64 = i;
+		epoll_ctl(m_epoll, EPOLL_CTL_MOD, m_timers[i], &ev);
+	}
+}
@@ -0,0 +1,74 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of AcquisitionReactor
+ */
+#ifndef AcquisitionReactor_h
+#define AcquisitionReactor_h
+
+#include "ScopePoller.h"
+#include <thread>
+
+/**
+	@brief Runs the polling state machines of many instruments on a small pool of threads.
+
+	Each instrument gets a ScopePoller and a timerfd, armed with the delay the poller asks for. The timers are all
+	registered with one epoll instance as EPOLLONESHOT, so whichever thread picks up an expired timer owns that
+	instrument until it re-arms it. The transports themselves are blocking, so a step ties up its thread for the
+	duration of the SCPI round trips, but no instrument is ever serviced by two threads at once.
+ */
+class AcquisitionReactor
+{
+public:
+	AcquisitionReactor(const std::vector<Oscilloscope*>& scopes, size_t nthreads);
+	~AcquisitionReactor();
+
+protected:
+	void ThreadProc();
+	void Arm(size_t i, uint32_t delay_us);
+
+	///@brief The epoll instance all timers are registered with
+	int m_epoll;
+
+	///@brief Signaled to wake every thread for shutdown
+	int m_stopEvent;
+
+	///@brief One poller per instrument
+	std::vector<ScopePoller*> m_pollers;
+
+	///@brief Timer for each poller, same indexes as m_pollers
+	std::vector<int> m_timers;
+
+	std::vector<std::thread*> m_threads;
+};
+
+#endif
@@ -0,0 +1,275 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of BackpressurePolicy
+ */
+#include "glscopeclient.h"
+#include "BackpressurePolicy.h"
+#include <errno.h>
+
+using namespace std;
+
+//Hard limits on the backlog regardless of policy, in case the UI stops consuming altogether
+#define BACKPRESSURE_HARD_MAX_WAVEFORMS		5000
+#define BACKPRESSURE_HARD_MAX_SECONDS		5
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// BackpressureConfig
+
+/**
+	@brief Initializes to the historical behavior: above 30 pending waveforms, only draw one in 25
+ */
+BackpressureConfig::BackpressureConfig()
+	: m_mode(BACKPRESSURE_DECIMATE)
+	, m_decimation(25)
+	, m_maxWaveforms(30)
+	, m_maxBytes(0)
+{
+}
+
+/**
+	@brief Parses a policy name: "block", "keep-latest", "decimate:N", or "spill:DIR"
+
+	@return False if the string isn't a valid policy
+ */
+bool BackpressureConfig::Parse(const string& str)
+{
+	if(str == "block")
+		m_mode = BACKPRESSURE_BLOCK;
+	else if(str == "keep-latest")
+		m_mode = BACKPRESSURE_KEEP_LATEST;
+	else if(str.find("decimate:") == 0)
+	{
+		m_mode = BACKPRESSURE_DECIMATE;
+		m_decimation = atoi(str.c_str() + strlen("decimate:"));
+		if(m_decimation < 2)
+			return false;
+	}
+	else if(str.find("spill:") == 0)
+	{
+		m_mode = BACKPRESSURE_SPILL;
+		m_spillDir = str.substr(strlen("spill:"));
+		if(m_spillDir.empty())
+			return false;
+	}
+	else
+		return false;
+
+	return true;
+}
+
+/**
+	@brief Sets one of the backpressure command line options (without the leading "--")
+
+	@return False if the option or its value isn't valid
+ */
+bool BackpressureConfig::SetOption(const string& name, const string& value)
+{
+	if(name == "backpressure")
+		return Parse(value);
+
+	if( (name != "max-pending-waveforms") && (name != "max-pending-bytes") )
+		return false;
+
+	char* end;
+	errno = 0;
+	unsigned long long n = strtoull(value.c_str(), &end, 10);
+	if(value.empty() || (value[0] == '-') || (*end != '\0') || (errno != 0) )
+		return false;
+
+	if(name == "max-pending-waveforms")
+		m_maxWaveforms = n;
+	else
+		m_maxBytes = n;
+	return true;
+}
+
+string BackpressureConfig::GetDescription() const
+{
+	char tmp[128];
+	switch(m_mode)
+	{
+		case BACKPRESSURE_BLOCK:
+			return "block";
+
+		case BACKPRESSURE_KEEP_LATEST:
+			return "keep-latest";
+
+		case BACKPRESSURE_DECIMATE:
+			snprintf(tmp, sizeof(tmp), "decimate:%zu", m_decimation);
+			return tmp;
+
+		case BACKPRESSURE_SPILL:
+		default:
+			return string("spill:") + m_spillDir;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// BackpressurePolicy
+
+BackpressurePolicy::BackpressurePolicy(const BackpressureConfig& config, Oscilloscope* scope, WaveformQueue* queue)
+	: m_config(config)
+	, m_scope(scope)
+	, m_queue(queue)
+	, m_waveformBytes(0)
+	, m_decimationPhase(0)
+	, m_spillWriter(NULL)
+	, m_dropped(0)
+	, m_skipped(0)
+	, m_spilled(0)
+	, m_paused(0)
+{
+	//Always keep at least one waveform to draw
+	if(m_config.m_maxWaveforms < 1)
+		m_config.m_maxWaveforms = 1;
+
+	if(m_config.m_mode == BACKPRESSURE_SPILL)
+		m_spillWriter = new SpillWriter(m_config.m_spillDir);
+}
+
+/**
+	@brief Waits for anything still being spilled to be written out
+ */
+BackpressurePolicy::~BackpressurePolicy()
+{
+	delete m_spillWriter;
+}
+
+/**
+	@brief Checks if the backlog is over the configured limits.
+
+	Never true with one or zero waveforms pending, so there's always something left for the UI to draw after
+	applying the policy.
+ */
+bool BackpressurePolicy::IsOverLimit()
+{
+	size_t npending = m_queue->size();
+	if(npending <= 1)
+		return false;
+	if(npending > m_config.m_maxWaveforms)
+		return true;
+	if( (m_config.m_maxBytes != 0) && (npending * m_waveformBytes > m_config.m_maxBytes) )
+		return true;
+	return false;
+}
+
+/**
+	@brief Decides whether the acquisition thread should hold off on triggering. Called from the acquisition thread.
+
+	@param dt	Time between the last two waveforms
+ */
+bool BackpressurePolicy::ShouldPause(double dt)
+{
+	//Don't let the backlog grow without bound, or get more than a few seconds behind the UI, whatever the policy
+	size_t npending = m_queue->size();
+	bool pause =
+		(npending > BACKPRESSURE_HARD_MAX_WAVEFORMS) ||
+		(npending*dt > BACKPRESSURE_HARD_MAX_SECONDS);
+
+	if( (m_config.m_mode == BACKPRESSURE_BLOCK) && IsOverLimit() )
+		pause = true;
+
+	//Spilling keeps everything, so if the disk can't keep up the only option left is to stop triggering
+	if(m_spillWriter && m_spillWriter->IsBacklogged())
+		pause = true;
+
+	if(pause)
+		m_paused ++;
+	return pause;
+}
+
+/**
+	@brief Decides what to do with the oldest pending waveform. Called from the UI thread.
+ */
+BackpressurePolicy::Action BackpressurePolicy::GetNextAction()
+{
+	if(!IsOverLimit())
+	{
+		m_decimationPhase = 0;
+		return ACTION_RENDER;
+	}
+
+	switch(m_config.m_mode)
+	{
+		case BACKPRESSURE_KEEP_LATEST:
+			m_dropped ++;
+			return ACTION_DROP;
+
+		case BACKPRESSURE_DECIMATE:
+			m_decimationPhase ++;
+			if(m_decimationPhase >= m_config.m_decimation)
+			{
+				m_decimationPhase = 0;
+				return ACTION_RENDER;
+			}
+			m_skipped ++;
+			return ACTION_SKIP;
+
+		case BACKPRESSURE_SPILL:
+			m_spilled ++;
+			return ACTION_SPILL;
+
+		case BACKPRESSURE_BLOCK:
+		default:
+			return ACTION_RENDER;
+	}
+}
+
+/**
+	@brief Updates the waveform size estimate from the waveform the scope's channels currently hold
+ */
+void BackpressurePolicy::OnWaveformAcquired()
+{
+	size_t bytes = 0;
+	for(size_t i=0; i<m_scope->GetChannelCount(); i++)
+	{
+		auto data = m_scope->GetChannel(i)->GetData();
+		auto adat = dynamic_cast<AnalogCapture*>(data);
+		auto ddat = dynamic_cast<DigitalCapture*>(data);
+		if(adat)
+			bytes += adat->m_samples.size() * sizeof(AnalogSample);
+		else if(ddat)
+			bytes += ddat->m_samples.size() * sizeof(DigitalSample);
+	}
+	m_waveformBytes = bytes;
+}
+
+/**
+	@brief Hands the waveform the scope's channels currently hold to the spill writer thread.
+
+	The channels are detached from the data, which now belongs to the writer.
+ */
+void BackpressurePolicy::SpillWaveform()
+{
+	m_spillWriter->Write(m_scope);
+}
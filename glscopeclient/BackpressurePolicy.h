@@ -0,0 +1,143 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of BackpressurePolicy
+ */
+#ifndef BackpressurePolicy_h
+#define BackpressurePolicy_h
+
+#include "ScopePoller.h"
+#include "SpillWriter.h"
+
+/**
+	@brief What to do when the UI falls behind an instrument
+ */
+enum BackpressureMode
+{
+	BACKPRESSURE_BLOCK,			//Stop triggering until the UI catches up
+	BACKPRESSURE_KEEP_LATEST,	//Throw away the oldest waveforms
+	BACKPRESSURE_DECIMATE,		//Only draw every Nth waveform (the rest still go to history and persistence)
+	BACKPRESSURE_SPILL			//Write the oldest waveforms to disk instead of displaying them
+};
+
+/**
+	@brief Backpressure settings for an instrument, from the command line
+ */
+class BackpressureConfig
+{
+public:
+	BackpressureConfig();
+
+	bool Parse(const std::string& str);
+	bool SetOption(const std::string& name, const std::string& value);
+	std::string GetDescription() const;
+
+	BackpressureMode m_mode;
+
+	///@brief Number of waveforms to skip per one drawn, for BACKPRESSURE_DECIMATE
+	size_t m_decimation;
+
+	///@brief Directory to write waveforms to, for BACKPRESSURE_SPILL
+	std::string m_spillDir;
+
+	///@brief Max number of waveforms waiting for the UI before the policy kicks in
+	size_t m_maxWaveforms;
+
+	///@brief Max size of the waveforms waiting for the UI before the policy kicks in, or 0 for no limit
+	size_t m_maxBytes;
+};
+
+/**
+	@brief Applies a BackpressureConfig to one instrument's waveform queue and counts what it threw away.
+
+	ShouldPause() is called from the acquisition thread, everything else from the UI thread.
+ */
+class BackpressurePolicy
+{
+public:
+	BackpressurePolicy(const BackpressureConfig& config, Oscilloscope* scope, WaveformQueue* queue);
+	~BackpressurePolicy();
+
+	enum Action
+	{
+		ACTION_RENDER,		//Process and draw the waveform
+		ACTION_SKIP,		//Process the waveform but don't draw it
+		ACTION_DROP,		//Throw the waveform away
+		ACTION_SPILL		//Write the waveform to disk, then throw it away
+	};
+
+	bool ShouldPause(double dt);
+	Action GetNextAction();
+
+	void OnWaveformAcquired();
+	void SpillWaveform();
+
+	size_t GetDroppedCount()
+	{ return m_dropped; }
+
+	const BackpressureConfig& GetConfig()
+	{ return m_config; }
+
+	size_t GetSkippedCount()
+	{ return m_skipped; }
+
+	size_t GetSpilledCount()
+	{ return m_spilled; }
+
+	size_t GetPausedCount()
+	{ return m_paused; }
+
+protected:
+	bool IsOverLimit();
+
+	BackpressureConfig m_config;
+
+	Oscilloscope* m_scope;
+	WaveformQueue* m_queue;
+
+	///@brief Approximate size of one waveform in bytes, as of the last one the UI fetched
+	std::atomic<size_t> m_waveformBytes;
+
+	///@brief Number of waveforms skipped since the last one drawn, for BACKPRESSURE_DECIMATE
+	size_t m_decimationPhase;
+
+	///@brief Background thread writing waveforms to disk, for BACKPRESSURE_SPILL
+	SpillWriter* m_spillWriter;
+
+	//Counters
+	size_t m_dropped;
+	size_t m_skipped;
+	size_t m_spilled;
+	std::atomic<size_t> m_paused;
+};
+
+#endif
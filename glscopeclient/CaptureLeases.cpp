@@ -0,0 +1,134 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of CaptureLeases
+ */
+#include "glscopeclient.h"
+#include "CaptureLeases.h"
+
+using namespace std;
+
+CaptureLeases::CaptureLeases()
+{
+}
+
+CaptureLeases::~CaptureLeases()
+{
+	//Anyone still holding a lease is gone by now, so nobody else will ever free these
+	for(auto data : m_orphans)
+		delete data;
+	if(!m_leases.empty())
+		LogDebug("CaptureLeases: %zu captures still leased at exit\n", m_leases.size());
+}
+
+/**
+	@brief Keeps a capture from being deleted until Release() is called on it (once per Acquire())
+ */
+void CaptureLeases::Acquire(CaptureChannelBase* data)
+{
+	if(data == NULL)
+		return;
+
+	lock_guard<mutex> lock(m_mutex);
+	m_leases[data] ++;
+}
+
+/**
+	@brief Gives up a lease, deleting the capture if it was the last one and the owner has already freed it.
+
+	Can be called from any thread.
+ */
+void CaptureLeases::Release(CaptureChannelBase* data)
+{
+	if(data == NULL)
+		return;
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+		auto it = m_leases.find(data);
+		if(it == m_leases.end())
+		{
+			LogError("CaptureLeases: releasing a capture that isn't leased\n");
+			return;
+		}
+		if(--it->second != 0)
+			return;
+		m_leases.erase(it);
+
+		if(m_orphans.erase(data) == 0)
+			return;
+	}
+
+	delete data;
+}
+
+/**
+	@brief Called by a capture's owner in place of deleting it. Deletes it now unless it's leased.
+ */
+void CaptureLeases::Free(CaptureChannelBase* data)
+{
+	if(data == NULL)
+		return;
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+		if(m_leases.find(data) != m_leases.end())
+		{
+			m_orphans.emplace(data);
+			return;
+		}
+	}
+
+	delete data;
+}
+
+/**
+	@brief Takes a leased capture away from the channel displaying it, so the channel can't delete it.
+
+	Call before anything that makes a channel replace or delete its own data. The capture is freed once it's no
+	longer leased, and the channel is left empty.
+ */
+void CaptureLeases::DetachIfLeased(OscilloscopeChannel* chan)
+{
+	auto data = chan->GetData();
+	if( (data == NULL) || !IsLeased(data) )
+		return;
+
+	chan->Detach();
+	Free(data);
+}
+
+bool CaptureLeases::IsLeased(CaptureChannelBase* data)
+{
+	lock_guard<mutex> lock(m_mutex);
+	return (m_leases.find(data) != m_leases.end());
+}
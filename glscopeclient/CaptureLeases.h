@@ -0,0 +1,76 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of CaptureLeases
+ */
+#ifndef CaptureLeases_h
+#define CaptureLeases_h
+
+#include <map>
+#include <mutex>
+#include <set>
+
+/**
+	@brief Reference counts on captures that something other than their owner is still reading.
+
+	Captures are never modified once they're fetched or decoded, so measurements running on the thread pool look at
+	the same capture the GTK thread displays rather than a copy. They take a lease on it for as long as they need it.
+
+	Owners (the history, the decoder cache) call Free() instead of deleting a capture. If it's leased, it's deleted
+	when the last lease is released instead. Channels that free their own data when it's replaced (decoders being
+	refreshed or deleted) have to be passed to DetachIfLeased() first.
+ */
+class CaptureLeases
+{
+public:
+	CaptureLeases();
+	~CaptureLeases();
+
+	void Acquire(CaptureChannelBase* data);
+	void Release(CaptureChannelBase* data);
+
+	void Free(CaptureChannelBase* data);
+	void DetachIfLeased(OscilloscopeChannel* chan);
+
+	bool IsLeased(CaptureChannelBase* data);
+
+protected:
+	std::mutex m_mutex;
+
+	///@brief Number of leases on each capture that has any
+	std::map<CaptureChannelBase*, size_t> m_leases;
+
+	///@brief Leased captures their owner has given up on, to be deleted when the last lease is released
+	std::set<CaptureChannelBase*> m_orphans;
+};
+
+#endif
@@ -0,0 +1,73 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Column index search used when preparing waveform geometry
+ */
+#ifndef ColumnIndex_h
+#define ColumnIndex_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+	@brief Find the first sample whose successor starts at or after a given X position
+
+	@param buf		X coordinates of each sample, must be monotonically increasing
+	@param count	Number of samples in the buffer
+	@param value	X position of the column to search for
+
+	@return Index of the sample to start drawing the column at, or count if there are none
+ */
+inline uint32_t BinarySearchForGequal(const float* buf, size_t count, float value)
+{
+	if(count < 2)
+		return count;
+
+	//Binary search for the first sample N (in [0, count-2]) such that sample N+1 ends at or after the column
+	size_t low = 0;
+	size_t high = count - 1;
+	while(low < high)
+	{
+		size_t mid = low + (high - low)/2;
+		if(buf[mid+1] >= value)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+
+	//Nothing in this column
+	if(low >= count-1)
+		return count;
+	return low;
+}
+
+#endif
@@ -0,0 +1,336 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of DecoderCache
+ */
+#include "glscopeclient.h"
+#include "DecoderCache.h"
+#include "../../lib/scopeprotocols/EyeDecoder2.h"
+#include "../../lib/scopeprotocols/WaterfallDecoder.h"
+
+using namespace std;
+
+extern CaptureLeases g_captureLeases;
+
+/**
+	@brief Creates an empty cache
+
+	@param budget	Max size of all cached captures, in bytes (approximate)
+ */
+DecoderCache::DecoderCache(size_t budget)
+	: m_budget(budget)
+	, m_bytesUsed(0)
+	, m_hits(0)
+	, m_misses(0)
+{
+}
+
+DecoderCache::~DecoderCache()
+{
+	Clear();
+}
+
+/**
+	@brief Detaches decoders from any captures the cache owns, so that refreshing them won't free our data.
+
+	Decoders we can't cache never hold our data, so they keep whatever they've accumulated.
+ */
+void DecoderCache::Release(const set<ProtocolDecoder*>& decoders)
+{
+	for(auto d : decoders)
+	{
+		if(m_owned.find(d->GetData()) != m_owned.end())
+			d->Detach();
+	}
+}
+
+/**
+	@brief Gives a decoder its cached output for the captures it's looking at, if we have one.
+
+	The decoder must not currently hold any data (call Release() first if it might).
+
+	@return True on a hit, false if the decoder will have to be refreshed
+ */
+bool DecoderCache::Load(ProtocolDecoder* decoder)
+{
+	Key key;
+	if(!GetKey(decoder, key))
+		return false;
+
+	auto it = m_entries.find(key);
+	if(it == m_entries.end())
+	{
+		m_misses ++;
+		return false;
+	}
+
+	//Move it to the front of the LRU list
+	m_lru.splice(m_lru.begin(), m_lru, it->second);
+
+	decoder->SetData(it->second->m_data);
+	m_hits ++;
+	return true;
+}
+
+/**
+	@brief Takes ownership of the decoders' current outputs as the results for the captures they're looking at.
+
+	Decoders we can't cache are skipped, and keep ownership of their output.
+ */
+void DecoderCache::Store(const set<ProtocolDecoder*>& decoders)
+{
+	for(auto d : decoders)
+	{
+		auto data = d->GetData();
+		if( (data == NULL) || (m_owned.find(data) != m_owned.end()) )
+			continue;
+
+		Key key;
+		if(!GetKey(d, key))
+			continue;
+
+		//Replace any old entry (shouldn't normally happen, but the decoder could have been refreshed by hand)
+		auto it = m_entries.find(key);
+		if(it != m_entries.end())
+			Remove(it->second);
+
+		Entry entry;
+		entry.m_key = key;
+		entry.m_data = data;
+		entry.m_size = GetSize(data);
+		m_lru.push_front(entry);
+		m_entries[key] = m_lru.begin();
+		m_owned.emplace(data);
+		m_bytesUsed += entry.m_size;
+	}
+
+	Evict();
+}
+
+/**
+	@brief Figures out the key for a decoder's output given what it's looking at right now
+
+	@return False if the decoder can't be cached
+ */
+bool DecoderCache::GetKey(ProtocolDecoder* decoder, Key& key)
+{
+	if(!IsCacheable(decoder))
+		return false;
+
+	//Nothing from the history to tie it to (a generator, or all inputs are empty)
+	GetCaptureTimes(decoder, key.m_times);
+	if(key.m_times.empty())
+		return false;
+
+	key.m_decoder = decoder;
+	key.m_config = GetConfig(decoder);
+	return true;
+}
+
+/**
+	@brief Checks if a decoder's output only depends on its configuration and the captures it's looking at.
+
+	Eye patterns and waterfalls integrate over every capture since they were last cleared, so their output can't be
+	saved and restored. Packet decoders also keep a packet list we have no way to save. Anything downstream of one of
+	those inherits the problem.
+ */
+bool DecoderCache::IsCacheable(ProtocolDecoder* decoder)
+{
+	if(dynamic_cast<EyeDecoder2*>(decoder) || dynamic_cast<WaterfallDecoder*>(decoder) ||
+		dynamic_cast<PacketDecoder*>(decoder) )
+	{
+		return false;
+	}
+
+	for(size_t i=0; i<decoder->GetInputCount(); i++)
+	{
+		auto upstream = dynamic_cast<ProtocolDecoder*>(decoder->GetInput(i));
+		if(upstream && !IsCacheable(upstream))
+			return false;
+	}
+	return true;
+}
+
+/**
+	@brief Finds the timestamps of every capture a decoder depends on, looking through upstream decoders.
+
+	All channels of an instrument share the timestamp of the capture, so these are the same keys the history window
+	uses for its rows, and passes to RemoveTimePoint() when it drops one.
+ */
+void DecoderCache::GetCaptureTimes(ProtocolDecoder* decoder, set<TimePoint>& times)
+{
+	for(size_t i=0; i<decoder->GetInputCount(); i++)
+	{
+		auto chan = decoder->GetInput(i);
+		if(chan == NULL)
+			continue;
+
+		auto upstream = dynamic_cast<ProtocolDecoder*>(chan);
+		if(upstream)
+		{
+			GetCaptureTimes(upstream, times);
+			continue;
+		}
+
+		auto data = chan->GetData();
+		if(data)
+			times.emplace(TimePoint(data->m_startTimestamp, data->m_startPicoseconds));
+	}
+}
+
+/**
+	@brief Checks if a decoder is displaying a capture right now, in which case we can't free it
+ */
+bool DecoderCache::IsInUse(CaptureChannelBase* data, ProtocolDecoder* decoder)
+{
+	return (decoder->GetData() == data);
+}
+
+/**
+	@brief Forgets an entry, and frees its capture unless a decoder is displaying it (in which case it's theirs now)
+
+	@return The next entry in the LRU list
+ */
+list<DecoderCache::Entry>::iterator DecoderCache::Remove(list<Entry>::iterator it)
+{
+	if(!IsInUse(it->m_data, it->m_key.m_decoder))
+		g_captureLeases.Free(it->m_data);
+	m_owned.erase(it->m_data);
+	m_bytesUsed -= it->m_size;
+	m_entries.erase(it->m_key);
+	return m_lru.erase(it);
+}
+
+/**
+	@brief Frees least recently used entries until we're under the budget. Skips entries in use.
+ */
+void DecoderCache::Evict()
+{
+	auto it = m_lru.end();
+	while( (m_bytesUsed > m_budget) && (it != m_lru.begin()) )
+	{
+		--it;
+		if(IsInUse(it->m_data, it->m_key.m_decoder))
+			continue;
+
+		it = Remove(it);
+	}
+}
+
+/**
+	@brief Forgets everything that depends on a capture that's been removed from the history
+ */
+void DecoderCache::RemoveTimePoint(TimePoint t)
+{
+	for(auto it = m_lru.begin(); it != m_lru.end(); )
+	{
+		if(it->m_key.m_times.find(t) == it->m_key.m_times.end())
+			++it;
+		else
+			it = Remove(it);
+	}
+}
+
+/**
+	@brief Forgets everything for a decoder that's about to be deleted.
+
+	The capture it's displaying, if any, goes back to being owned by the decoder.
+ */
+void DecoderCache::RemoveDecoder(ProtocolDecoder* decoder)
+{
+	for(auto it = m_lru.begin(); it != m_lru.end(); )
+	{
+		if(it->m_key.m_decoder != decoder)
+			++it;
+		else
+			it = Remove(it);
+	}
+}
+
+/**
+	@brief Frees everything. Captures decoders are displaying go back to being owned by the decoders.
+ */
+void DecoderCache::Clear()
+{
+	for(auto& e : m_lru)
+	{
+		if(!IsInUse(e.m_data, e.m_key.m_decoder))
+			g_captureLeases.Free(e.m_data);
+	}
+	m_lru.clear();
+	m_entries.clear();
+	m_owned.clear();
+	m_bytesUsed = 0;
+}
+
+/**
+	@brief Describes everything about a decoder's configuration that affects its output.
+
+	Upstream decoders' configurations are included, since changing one changes what this decoder sees.
+ */
+string DecoderCache::GetConfig(ProtocolDecoder* decoder)
+{
+	string config;
+	char tmp[32];
+	for(size_t i=0; i<decoder->GetInputCount(); i++)
+	{
+		auto chan = decoder->GetInput(i);
+		snprintf(tmp, sizeof(tmp), "%p;", chan);
+		config += tmp;
+
+		auto upstream = dynamic_cast<ProtocolDecoder*>(chan);
+		if(upstream)
+			config += "{" + GetConfig(upstream) + "}";
+	}
+	for(auto it = decoder->GetParamBegin(); it != decoder->GetParamEnd(); it ++)
+		config += it->first + "=" + it->second.ToString() + ";";
+	return config;
+}
+
+/**
+	@brief Approximate size of a capture in bytes.
+
+	We only know the sample sizes of analog and digital captures, assume everything else (protocol symbols etc) is
+	around 64 bytes per sample.
+ */
+size_t DecoderCache::GetSize(CaptureChannelBase* data)
+{
+	auto adat = dynamic_cast<AnalogCapture*>(data);
+	if(adat)
+		return sizeof(AnalogCapture) + adat->m_samples.capacity() * sizeof(AnalogSample);
+
+	auto ddat = dynamic_cast<DigitalCapture*>(data);
+	if(ddat)
+		return sizeof(DigitalCapture) + ddat->m_samples.capacity() * sizeof(DigitalSample);
+
+	return data->GetDepth() * 64;
+}
@@ -0,0 +1,136 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of DecoderCache
+ */
+#ifndef DecoderCache_h
+#define DecoderCache_h
+
+#include <list>
+#include "ProtocolAnalyzerWindow.h"
+
+/**
+	@brief Saved protocol decoder outputs for waveforms in the history, so revisiting one doesn't have to decode again.
+
+	Entries are keyed by the timestamps of the captures the decoder reads (following its inputs through any upstream
+	decoders, so they match the keys the history window removes), the decoder, and a string describing the decoder's
+	configuration including everything upstream of it. They're evicted least recently used first once they take up
+	more than the memory budget.
+
+	Decoders whose output isn't a function of the current captures alone (eye patterns and waterfalls accumulate
+	across captures, packet decoders keep a packet list we can't save) are never cached, nor is anything downstream
+	of them. They're always refreshed.
+
+	The cache owns every capture stored in it, including the ones decoders are currently displaying. Call Release()
+	before refreshing decoders, so they don't free a capture the cache still holds. Captures it drops go through
+	CaptureLeases::Free(), since a measurement might still be looking at one.
+ */
+class DecoderCache
+{
+public:
+	DecoderCache(size_t budget);
+	~DecoderCache();
+
+	void Release(const std::set<ProtocolDecoder*>& decoders);
+	bool Load(ProtocolDecoder* decoder);
+	void Store(const std::set<ProtocolDecoder*>& decoders);
+
+	void RemoveTimePoint(TimePoint t);
+	void RemoveDecoder(ProtocolDecoder* decoder);
+	void Clear();
+
+	size_t GetHitCount()
+	{ return m_hits; }
+
+	size_t GetMissCount()
+	{ return m_misses; }
+
+	size_t GetBytesUsed()
+	{ return m_bytesUsed; }
+
+	size_t GetEntryCount()
+	{ return m_lru.size(); }
+
+	static bool IsCacheable(ProtocolDecoder* decoder);
+
+protected:
+	static std::string GetConfig(ProtocolDecoder* decoder);
+	static void GetCaptureTimes(ProtocolDecoder* decoder, std::set<TimePoint>& times);
+	static size_t GetSize(CaptureChannelBase* data);
+
+	void Evict();
+	bool IsInUse(CaptureChannelBase* data, ProtocolDecoder* decoder);
+
+	class Key
+	{
+	public:
+		std::set<TimePoint> m_times;
+		ProtocolDecoder* m_decoder;
+		std::string m_config;
+
+		bool operator<(const Key& rhs) const
+		{
+			if(m_times != rhs.m_times)
+				return m_times < rhs.m_times;
+			if(m_decoder != rhs.m_decoder)
+				return m_decoder < rhs.m_decoder;
+			return m_config < rhs.m_config;
+		}
+	};
+
+	class Entry
+	{
+	public:
+		Key m_key;
+		CaptureChannelBase* m_data;
+		size_t m_size;
+	};
+
+	bool GetKey(ProtocolDecoder* decoder, Key& key);
+	std::list<Entry>::iterator Remove(std::list<Entry>::iterator it);
+
+	///@brief Entries, most recently used first
+	std::list<Entry> m_lru;
+
+	std::map<Key, std::list<Entry>::iterator> m_entries;
+
+	///@brief Every capture we own, for telling our data apart from a decoder's own
+	std::set<CaptureChannelBase*> m_owned;
+
+	size_t m_budget;
+	size_t m_bytesUsed;
+
+	size_t m_hits;
+	size_t m_misses;
+};
+
+#endif
@@ -0,0 +1,193 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of DecoderScheduler
+ */
+#include "glscopeclient.h"
+#include "DecoderScheduler.h"
+
+using namespace std;
+
+extern bool g_parallelRefresh;
+
+DecoderScheduler::DecoderScheduler(ThreadPool* pool)
+	: m_pool(pool)
+	, m_running(0)
+{
+}
+
+/**
+	@brief Marks every decoder in the set dirty and refreshes them all. Returns once they're all done.
+ */
+void DecoderScheduler::RefreshAll(const set<ProtocolDecoder*>& decoders)
+{
+	if(decoders.empty())
+		return;
+
+	for(auto d : decoders)
+		d->SetDirty();
+
+	//Build the graph. Inputs that aren't decoders in the set are raw channels (or decoders we don't own)
+	//and are already up to date.
+	m_nodes.assign(decoders.begin(), decoders.end());
+	map<ProtocolDecoder*, size_t> indexes;
+	for(size_t i=0; i<m_nodes.size(); i++)
+		indexes[m_nodes[i]] = i;
+
+	m_downstream.clear();
+	m_downstream.resize(m_nodes.size());
+	vector<size_t> nupstream(m_nodes.size(), 0);
+	for(size_t i=0; i<m_nodes.size(); i++)
+	{
+		auto d = m_nodes[i];
+		set<size_t> upstream;
+		for(size_t j=0; j<d->GetInputCount(); j++)
+		{
+			auto it = indexes.find(dynamic_cast<ProtocolDecoder*>(d->GetInput(j)));
+			if( (it != indexes.end()) && (it->second != i) )
+				upstream.emplace(it->second);
+		}
+		for(auto u : upstream)
+			m_downstream[u].push_back(i);
+		nupstream[i] = upstream.size();
+	}
+
+	//Make sure it's acyclic before we start, or we'd wait forever for a decoder that can never run.
+	//Shouldn't be possible to set up, but if it happens fall back to letting RefreshIfDirty() sort it out.
+	vector<size_t> order;
+	vector<size_t> nleft = nupstream;
+	for(size_t i=0; i<m_nodes.size(); i++)
+	{
+		if(nleft[i] == 0)
+			order.push_back(i);
+	}
+	for(size_t k=0; k<order.size(); k++)
+	{
+		for(auto j : m_downstream[order[k]])
+		{
+			if(--nleft[j] == 0)
+				order.push_back(j);
+		}
+	}
+	if(order.size() != m_nodes.size())
+	{
+		LogWarning("Protocol decoders have a dependency cycle, refreshing serially\n");
+		for(auto d : m_nodes)
+			d->RefreshIfDirty();
+		return;
+	}
+
+	//Serial refresh, in an order where every decoder's inputs are up to date before it runs
+	if(!g_parallelRefresh)
+	{
+		for(auto i : order)
+			m_nodes[i]->RefreshIfDirty();
+		return;
+	}
+
+	//Kick off everything with no dependencies
+	for(size_t i=0; i<m_nodes.size(); i++)
+		m_waitingOn.push_back(new atomic<size_t>(nupstream[i]));
+	m_error = nullptr;
+	for(size_t i=0; i<m_nodes.size(); i++)
+	{
+		if(nupstream[i] == 0)
+			Start(i);
+	}
+
+	//Wait for them all to finish (or everything that was started, if one failed)
+	exception_ptr error;
+	{
+		unique_lock<mutex> lock(m_doneMutex);
+		m_doneCond.wait(lock, [this]{ return m_running == 0; });
+		error = m_error;
+		m_error = nullptr;
+	}
+
+	for(auto w : m_waitingOn)
+		delete w;
+	m_waitingOn.clear();
+
+	if(error)
+		rethrow_exception(error);
+}
+
+void DecoderScheduler::Start(size_t i)
+{
+	{
+		lock_guard<mutex> lock(m_doneMutex);
+		m_running ++;
+	}
+
+	m_pool->Submit([this, i]
+	{
+		exception_ptr error;
+		try
+		{
+			m_nodes[i]->RefreshIfDirty();
+		}
+		catch(...)
+		{
+			error = current_exception();
+		}
+		OnDone(i, error);
+	});
+}
+
+/**
+	@brief Starts any downstream decoders that were only waiting on this one, unless something failed
+ */
+void DecoderScheduler::OnDone(size_t i, exception_ptr error)
+{
+	bool failed;
+	{
+		lock_guard<mutex> lock(m_doneMutex);
+		if(error && !m_error)
+			m_error = error;
+		failed = (m_error != nullptr);
+	}
+
+	if(!failed)
+	{
+		for(auto j : m_downstream[i])
+		{
+			if(--(*m_waitingOn[j]) == 0)
+				Start(j);
+		}
+	}
+
+	//Started our downstream decoders before saying we're done, so the count can't hit zero early
+	lock_guard<mutex> lock(m_doneMutex);
+	m_running --;
+	if(m_running == 0)
+		m_doneCond.notify_all();
+}
@@ -0,0 +1,81 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of DecoderScheduler
+ */
+#ifndef DecoderScheduler_h
+#define DecoderScheduler_h
+
+#include "ThreadPool.h"
+#include <atomic>
+#include <exception>
+
+/**
+	@brief Refreshes a set of protocol decoders in parallel, in dependency order.
+
+	Builds a graph from each decoder's inputs, then starts every decoder with no dirty upstream decoders on the
+	pool. Each one that finishes starts any of its downstream decoders whose inputs are now all up to date, so a
+	chain (CDR -> eye -> 8b10b -> protocol) runs as soon as each stage is done while unrelated chains run
+	alongside it.
+
+	Not every decoder is known to be safe to run alongside others yet, so unless --parallel-refresh is given the
+	decoders are refreshed one at a time on the calling thread, in the same dependency order.
+
+	If a decoder throws, nothing downstream of anything that failed is started, and the first exception is rethrown
+	from RefreshAll() once everything already running has finished.
+ */
+class DecoderScheduler
+{
+public:
+	DecoderScheduler(ThreadPool* pool);
+
+	void RefreshAll(const std::set<ProtocolDecoder*>& decoders);
+
+protected:
+	void Start(size_t i);
+	void OnDone(size_t i, std::exception_ptr error);
+
+	ThreadPool* m_pool;
+
+	//The graph for the current run
+	std::vector<ProtocolDecoder*> m_nodes;
+	std::vector< std::vector<size_t> > m_downstream;
+	std::vector< std::atomic<size_t>* > m_waitingOn;
+
+	//Completion tracking
+	std::mutex m_doneMutex;
+	std::condition_variable m_doneCond;
+	size_t m_running;
+	std::exception_ptr m_error;
+};
+
+#endif
@@ -38,6 +38,8 @@
 
 using namespace std;
 
+extern CaptureLeases g_captureLeases;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // HistoryColumns
 
@@ -96,7 +98,7 @@ HistoryWindow::~HistoryWindow()
 	{
 		WaveformHistory hist = it[m_columns.m_history];
 		for(auto w : hist)
-			delete w.second;
+			g_captureLeases.Free(w.second);
 	}
 }
 
@@ -183,7 +185,7 @@ void HistoryWindow::OnWaveformDataReady(Oscilloscope* scope)
 		//Delete the saved waveform data
 		hist = (*it)[m_columns.m_history];
 		for(auto w : hist)
-			delete w.second;
+			g_captureLeases.Free(w.second);
 
 		m_model->erase(it);
 	}
@@ -141,5 +141,16 @@ void MeasurementDialog::ConfigureMeasurement()
 	*/
 }
 
+/**
+	@brief Gets the channels selected for each input
+ */
+std::vector<OscilloscopeChannel*> MeasurementDialog::GetInputs()
+{
+	std::vector<OscilloscopeChannel*> inputs;
+	for(auto r : m_rows)
+		inputs.push_back(r->m_chanptrs[r->m_chans.get_active_text()]);
+	return inputs;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Event handlers
@@ -48,6 +48,7 @@ public:
 	virtual ~MeasurementDialog();
 
 	void ConfigureMeasurement();
+	std::vector<OscilloscopeChannel*> GetInputs();
 
 protected:
 	Measurement* m_measurement;
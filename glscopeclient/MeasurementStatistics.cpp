@@ -0,0 +1,186 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of MeasurementStatistics
+ */
+#include "glscopeclient.h"
+#include "MeasurementStatistics.h"
+
+using namespace std;
+
+MeasurementStatistics::MeasurementStatistics()
+{
+	Reset();
+}
+
+void MeasurementStatistics::Reset()
+{
+	m_count = 0;
+	m_min = 0;
+	m_max = 0;
+	m_mean = 0;
+	m_m2 = 0;
+	m_histLow = 0;
+	m_binWidth = 0;
+	for(size_t i=0; i<MEASUREMENT_HISTOGRAM_BINS; i++)
+		m_bins[i] = 0;
+}
+
+/**
+	@brief Adds one value to the statistics
+ */
+void MeasurementStatistics::Update(double x)
+{
+	if(!isfinite(x))
+		return;
+
+	m_count ++;
+	if(m_count == 1)
+	{
+		m_min = x;
+		m_max = x;
+		m_histLow = x;
+	}
+	else
+	{
+		m_min = min(m_min, x);
+		m_max = max(m_max, x);
+	}
+
+	//Welford's update
+	double delta = x - m_mean;
+	m_mean += delta / m_count;
+	m_m2 += delta * (x - m_mean);
+
+	//Histogram
+	if(m_binWidth == 0)
+	{
+		//Still all the same value, everything goes in the first bin
+		if(x == m_histLow)
+		{
+			m_bins[0] ++;
+			return;
+		}
+
+		//Second distinct value. Span both values with the old one at the bottom or top of the range,
+		//so there's room left over for more values on the same side as the new one.
+		size_t nold = m_bins[0];
+		m_bins[0] = 0;
+		m_binWidth = fabs(x - m_histLow) / (MEASUREMENT_HISTOGRAM_BINS / 2);
+		if(x < m_histLow)
+		{
+			m_histLow -= m_binWidth * (MEASUREMENT_HISTOGRAM_BINS / 2);
+			m_bins[MEASUREMENT_HISTOGRAM_BINS / 2] = nold;
+		}
+		else
+			m_bins[0] = nold;
+	}
+
+	GrowHistogram(x);
+
+	size_t bin = (x - m_histLow) / m_binWidth;
+	if(bin >= MEASUREMENT_HISTOGRAM_BINS)
+		bin = MEASUREMENT_HISTOGRAM_BINS - 1;
+	m_bins[bin] ++;
+}
+
+/**
+	@brief Doubles the histogram range until it covers x
+ */
+void MeasurementStatistics::GrowHistogram(double x)
+{
+	const size_t half = MEASUREMENT_HISTOGRAM_BINS / 2;
+
+	while(true)
+	{
+		double range = m_binWidth * MEASUREMENT_HISTOGRAM_BINS;
+		bool below = (x < m_histLow);
+		bool above = (x >= m_histLow + range);
+		if(!below && !above)
+			return;
+
+		//Merge adjacent pairs of bins into one half of the histogram, and clear the other half
+		size_t merged[half];
+		for(size_t i=0; i<half; i++)
+			merged[i] = m_bins[2*i] + m_bins[2*i + 1];
+
+		size_t base = below ? half : 0;
+		for(size_t i=0; i<MEASUREMENT_HISTOGRAM_BINS; i++)
+			m_bins[i] = 0;
+		for(size_t i=0; i<half; i++)
+			m_bins[base + i] = merged[i];
+
+		if(below)
+			m_histLow -= range;
+		m_binWidth *= 2;
+	}
+}
+
+/**
+	@brief Sample standard deviation, or zero with fewer than two values
+ */
+double MeasurementStatistics::GetStdDev()
+{
+	if(m_count < 2)
+		return 0;
+	return sqrt(m_m2 / (m_count - 1));
+}
+
+/**
+	@brief Draws the occupied part of the histogram as a row of block characters, scaled to the fullest bin
+ */
+string MeasurementStatistics::GetHistogramString()
+{
+	static const char* blocks[] = { " ", "▁", "▂", "▃", "▄", "▅", "▆", "▇", "█" };
+
+	size_t first = MEASUREMENT_HISTOGRAM_BINS;
+	size_t last = 0;
+	size_t peak = 0;
+	for(size_t i=0; i<MEASUREMENT_HISTOGRAM_BINS; i++)
+	{
+		if(m_bins[i] == 0)
+			continue;
+		first = min(first, i);
+		last = i;
+		peak = max(peak, m_bins[i]);
+	}
+	if(peak == 0)
+		return "";
+
+	string ret;
+	for(size_t i=first; i<=last; i++)
+	{
+		size_t level = (m_bins[i] * 8 + peak - 1) / peak;
+		ret += blocks[level];
+	}
+	return ret;
+}
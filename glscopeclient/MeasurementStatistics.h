@@ -0,0 +1,99 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of MeasurementStatistics
+ */
+#ifndef MeasurementStatistics_h
+#define MeasurementStatistics_h
+
+//Number of bins in the histogram (must be even)
+#define MEASUREMENT_HISTOGRAM_BINS	32
+
+/**
+	@brief Running statistics of a measurement across many waveforms, in constant memory.
+
+	Mean and variance use Welford's online algorithm so they stay accurate over millions of samples. The histogram
+	has a fixed number of bins, and starts out covering just the first few values. When a value lands outside it,
+	the range doubles (towards the new value) and pairs of adjacent bins are merged, so every bin boundary stays
+	exact and no counts are lost.
+ */
+class MeasurementStatistics
+{
+public:
+	MeasurementStatistics();
+
+	void Reset();
+	void Update(double x);
+
+	size_t GetCount()
+	{ return m_count; }
+
+	double GetMin()
+	{ return m_min; }
+
+	double GetMax()
+	{ return m_max; }
+
+	double GetMean()
+	{ return m_mean; }
+
+	double GetStdDev();
+
+	std::string GetHistogramString();
+
+	double GetHistogramLow()
+	{ return m_histLow; }
+
+	double GetBinWidth()
+	{ return m_binWidth; }
+
+	size_t GetBinCount(size_t bin)
+	{ return m_bins[bin]; }
+
+protected:
+	void GrowHistogram(double x);
+
+	size_t m_count;
+	double m_min;
+	double m_max;
+
+	//Welford accumulators
+	double m_mean;
+	double m_m2;
+
+	//Histogram, starting at m_histLow with bins m_binWidth wide. Width of 0 means all values so far were identical.
+	double m_histLow;
+	double m_binWidth;
+	size_t m_bins[MEASUREMENT_HISTOGRAM_BINS];
+};
+
+#endif
@@ -0,0 +1,214 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of MinMaxPyramid
+ */
+#include "glscopeclient.h"
+#include "MinMaxPyramid.h"
+
+using namespace std;
+
+//Don't decimate down to fewer buckets than this, there's nothing to gain
+#define MIN_BUCKETS 64
+
+MinMaxPyramid::MinMaxPyramid()
+	: m_capture(NULL)
+{
+}
+
+/**
+	@brief Frees all pyramid levels
+ */
+void MinMaxPyramid::Clear()
+{
+	m_levels.clear();
+	m_levels.shrink_to_fit();
+	m_capture = NULL;
+}
+
+/**
+	@brief Picks the coarsest level whose buckets are no more than one pixel wide, building it if needed.
+
+	@param capture			The capture being drawn
+	@param xscale			Pixels per capture timestamp unit
+	@param xoff				X position of timestamp zero, in pixels
+	@param width			Width of the plot, in pixels
+
+	@return The selected level, or zero if the raw samples should be drawn
+ */
+size_t MinMaxPyramid::SelectLevel(AnalogCapture* capture, double xscale, double xoff, size_t width)
+{
+	//Throw out the old pyramid if it was for a different capture
+	if(capture != m_capture)
+	{
+		Clear();
+		m_capture = capture;
+	}
+
+	size_t depth = capture->GetDepth();
+	if( (xscale <= 0) || (depth < 2*MIN_BUCKETS) )
+		return 0;
+
+	//Only the samples on screen matter
+	size_t first;
+	size_t last;
+	GetVisibleRange(xscale, xoff, width, first, last);
+	if(last <= first)
+		return 0;
+
+	//Start from the level the average sample spacing on screen calls for
+	double pixelsPerSample = xscale * (capture->GetSampleStart(last) - capture->GetSampleStart(first)) / (last - first);
+	size_t level = 0;
+	while( ((pixelsPerSample * (2 << level)) <= 1) && ((depth >> (level+1)) >= MIN_BUCKETS) )
+		level ++;
+
+	//Then back off until no visible bucket is wider than a pixel, in case the samples aren't evenly spaced.
+	//This only looks at about one bucket per pixel unless the capture is very irregular.
+	while( (level > 0) && (GetMaxBucketSpan(level, first, last) * xscale > 1) )
+		level --;
+
+	//Lazily build everything up to the level we need
+	for(size_t i=m_levels.size()+1; i<=level; i++)
+		BuildLevel(i);
+
+	return level;
+}
+
+/**
+	@brief Finds the first and last samples that are at least partly on screen
+ */
+void MinMaxPyramid::GetVisibleRange(double xscale, double xoff, size_t width, size_t& first, size_t& last)
+{
+	int64_t tstart = floor(-xoff / xscale);
+	int64_t tend = ceil((width - xoff) / xscale);
+
+	//Include the sample before the left edge, since its line extends onto the screen
+	first = BinarySearchForSampleStart(tstart);
+	if(first > 0)
+		first --;
+
+	last = BinarySearchForSampleStart(tend);
+	if(last >= m_capture->GetDepth())
+		last = m_capture->GetDepth() - 1;
+}
+
+/**
+	@brief Finds the first sample starting at or after a given timestamp (or the depth, if there isn't one)
+ */
+size_t MinMaxPyramid::BinarySearchForSampleStart(int64_t t)
+{
+	size_t low = 0;
+	size_t high = m_capture->GetDepth();
+	while(low < high)
+	{
+		size_t mid = low + (high - low)/2;
+		if(m_capture->GetSampleStart(mid) < t)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+/**
+	@brief Gets the widest bucket of a level (time between its first and last samples) that overlaps a range of
+	samples.
+
+	Only needs the capture's timestamps, so the level doesn't have to be built yet.
+ */
+int64_t MinMaxPyramid::GetMaxBucketSpan(size_t level, size_t first, size_t last)
+{
+	auto& cap = *m_capture;
+	size_t depth = cap.GetDepth();
+	int64_t firstBucket = first >> level;
+	int64_t lastBucket = last >> level;
+
+	int64_t span = 0;
+	#pragma omp parallel for reduction(max:span)
+	for(int64_t i=firstBucket; i<=lastBucket; i++)
+	{
+		size_t start = i << level;
+		size_t end = min( (size_t)((i+1) << level), depth) - 1;
+		span = max(span, cap.GetSampleStart(end) - cap.GetSampleStart(start));
+	}
+	return span;
+}
+
+/**
+	@brief Builds a single level from the next finer level (or the raw capture, for level 1)
+ */
+void MinMaxPyramid::BuildLevel(size_t level)
+{
+	m_levels.resize(level);
+	auto& l = m_levels[level-1];
+
+	//Level 1 comes straight from the capture
+	if(level == 1)
+	{
+		auto& cap = *m_capture;
+		size_t depth = cap.GetDepth();
+		size_t len = (depth + 1) / 2;
+		l.m_min.resize(len);
+		l.m_max.resize(len);
+
+		#pragma omp parallel for
+		for(size_t i=0; i<len; i++)
+		{
+			float a = cap[i*2];
+			float b = a;
+			if(i*2 + 1 < depth)
+				b = cap[i*2 + 1];
+			l.m_min[i] = min(a, b);
+			l.m_max[i] = max(a, b);
+		}
+	}
+
+	//Higher levels merge pairs of buckets from the level below
+	else
+	{
+		auto& prev = m_levels[level-2];
+		size_t plen = prev.m_min.size();
+		size_t len = (plen + 1) / 2;
+		l.m_min.resize(len);
+		l.m_max.resize(len);
+
+		#pragma omp parallel for
+		for(size_t i=0; i<len; i++)
+		{
+			size_t right = i*2 + 1;
+			if(right >= plen)
+				right = i*2;
+			l.m_min[i] = min(prev.m_min[i*2], prev.m_min[right]);
+			l.m_max[i] = max(prev.m_max[i*2], prev.m_max[right]);
+		}
+	}
+}
@@ -0,0 +1,110 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of MinMaxPyramid
+ */
+#ifndef MinMaxPyramid_h
+#define MinMaxPyramid_h
+
+/**
+	@brief Min/max decimation of an analog capture, used for rendering at very wide zooms.
+
+	Level N of the pyramid has one bucket per 2^N samples, storing the smallest and largest value in the bucket.
+	Each bucket is rendered as two points (min at the start of the bucket, max halfway through) so a view
+	zoomed out far enough to have many samples per pixel only has to draw a couple of points per pixel.
+
+	Levels are built on demand from the next finer level and kept until the capture changes.
+
+	Buckets are a fixed number of samples, not a fixed amount of time, so the level is chosen from the widest
+	bucket in the visible range rather than the average sample rate. That way gaps in sparse or irregularly
+	sampled captures are never merged into a single bucket.
+ */
+class MinMaxPyramid
+{
+public:
+	MinMaxPyramid();
+
+	void Clear();
+
+	size_t SelectLevel(AnalogCapture* capture, double xscale, double xoff, size_t width);
+
+	/**
+		@brief Number of points to draw for a given (nonzero) level
+	 */
+	size_t GetPointCount(size_t level)
+	{ return m_levels[level-1].m_min.size() * 2; }
+
+	/**
+		@brief Get the timestamp (in capture units) and value of a single point at a given (nonzero) level
+	 */
+	void GetPoint(size_t level, size_t i, int64_t& timestamp, float& value)
+	{
+		auto& l = m_levels[level-1];
+		size_t bucket = i / 2;
+		size_t first = bucket << level;
+
+		//Min at the start of the bucket, max halfway through it
+		size_t sample = first;
+		if(i & 1)
+		{
+			value = l.m_max[bucket];
+			sample += (1 << (level-1));
+			if(sample >= m_capture->GetDepth())
+				sample = m_capture->GetDepth() - 1;
+		}
+		else
+			value = l.m_min[bucket];
+
+		timestamp = m_capture->GetSampleStart(sample);
+	}
+
+protected:
+	void BuildLevel(size_t level);
+	void GetVisibleRange(double xscale, double xoff, size_t width, size_t& first, size_t& last);
+	int64_t GetMaxBucketSpan(size_t level, size_t first, size_t last);
+	size_t BinarySearchForSampleStart(int64_t t);
+
+	class Level
+	{
+	public:
+		std::vector<float> m_min;
+		std::vector<float> m_max;
+	};
+
+	///@brief The capture the pyramid was built from
+	AnalogCapture* m_capture;
+
+	///@brief Decimation levels built so far (m_levels[0] is level 1, two samples per bucket)
+	std::vector<Level> m_levels;
+};
+
+#endif
@@ -39,6 +39,14 @@
 
 using namespace std;
 
+extern map<Oscilloscope*, WaveformQueue*> g_waveformQueues;
+extern map<Oscilloscope*, BackpressurePolicy*> g_backpressurePolicies;
+extern double g_syncTolerance;
+extern double g_syncTimeout;
+extern ThreadPool* g_threadPool;
+extern size_t g_decodeCacheBudget;
+extern CaptureLeases g_captureLeases;
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Construction / destruction
 
@@ -48,6 +56,8 @@ using namespace std;
 OscilloscopeWindow::OscilloscopeWindow(vector<Oscilloscope*> scopes)
 	: m_historyWindow(this)
 	, m_scopes(scopes)
+	, m_decoderScheduler(g_threadPool)
+	, m_decoderCache(g_decodeCacheBudget)
 	// m_iconTheme(Gtk::IconTheme::get_default())
 {
 	//Set title
@@ -90,6 +100,11 @@ OscilloscopeWindow::OscilloscopeWindow(vector<Oscilloscope*> scopes)
 	m_tHistory = 0;
 	m_tPoll = 0;
 	m_tEvent = 0;
+	m_tLatency = 0;
+	m_tMaxLatency = 0;
+	m_latencyCount = 0;
+	m_syncMatched = 0;
+	m_syncUnmatched = 0;
 }
 
 /**
@@ -97,6 +112,8 @@ OscilloscopeWindow::OscilloscopeWindow(vector<Oscilloscope*> scopes)
  */
 OscilloscopeWindow::~OscilloscopeWindow()
 {
+	m_syncTimer.disconnect();
+
 	//Print stats
 	LogDebug("ACQUIRE: %.3f ms\n", m_tAcquire * 1000);
 	LogDebug("DECODE:  %.3f ms\n", m_tDecode * 1000);
@@ -104,6 +121,34 @@ OscilloscopeWindow::~OscilloscopeWindow()
 	LogDebug("HISTORY: %.3f ms\n", m_tHistory * 1000);
 	LogDebug("POLL:    %.3f ms\n", m_tPoll * 1000);
 	LogDebug("EVENT:   %.3f ms\n", m_tEvent * 1000);
+	if(m_latencyCount)
+	{
+		LogDebug("LATENCY: %.3f ms avg, %.3f ms max (download to view update, %zu samples)\n",
+			m_tLatency * 1000 / m_latencyCount, m_tMaxLatency * 1000, m_latencyCount);
+	}
+
+	if( (g_syncTolerance > 0) && (m_scopes.size() > 1) )
+		LogDebug("SYNC:    %zu matched sets, %zu unmatched waveforms dropped\n", m_syncMatched, m_syncUnmatched);
+	for(auto& it : m_syncStaged)
+		FreeStagedWaveform(it.second);
+	for(auto scope : m_scopes)
+	{
+		auto policy = g_backpressurePolicies.at(scope);
+		LogDebug("%s: %zu dropped, %zu skipped, %zu spilled, %zu polls paused by backpressure\n",
+			scope->m_nickname.c_str(),
+			policy->GetDroppedCount(),
+			policy->GetSkippedCount(),
+			policy->GetSpilledCount(),
+			policy->GetPausedCount());
+	}
+
+	LogDebug("DECODE CACHE: %zu hits, %zu misses, %.1f MB\n",
+		m_decoderCache.GetHitCount(),
+		m_decoderCache.GetMissCount(),
+		m_decoderCache.GetBytesUsed() / (1024.0f * 1024.0f));
+
+	//Free cached decodes while the decoders are still around to take back the ones they're using
+	m_decoderCache.Clear();
 
 	for(auto a : m_analyzers)
 		delete a;
@@ -255,6 +300,7 @@ void OscilloscopeWindow::CreateWidgets()
 		m_vbox.pack_start(m_statusbar, Gtk::PACK_SHRINK);
 		m_statusbar.pack_end(m_triggerConfigLabel, Gtk::PACK_SHRINK);
 		m_triggerConfigLabel.set_size_request(75, 1);
+		m_statusbar.pack_end(m_backpressureLabel, Gtk::PACK_SHRINK);
 
 	//Process all of the channels
 	for(auto scope : m_scopes)
@@ -572,7 +618,7 @@ void OscilloscopeWindow::ClearPersistence(WaveformGroup* group, bool dirty)
 				if(area != NULL)
 				{
 					if(dirty)
-						area->SetGeometryDirty();
+						area->SetDirty(WaveformArea::DIRTY_X);
 					area->ClearPersistence();
 				}
 			}
@@ -592,6 +638,24 @@ void OscilloscopeWindow::ClearAllPersistence()
 	}
 }
 
+/**
+	@brief Tells every view showing a channel that its name or other displayed settings changed
+ */
+void OscilloscopeWindow::OnChannelPropertiesChanged(OscilloscopeChannel* chan)
+{
+	for(auto w : m_waveformAreas)
+		w->OnChannelPropertiesChanged(chan);
+}
+
+/**
+	@brief Tells every view which decoders just ran
+ */
+void OscilloscopeWindow::OnDecodersRefreshed(const set<ProtocolDecoder*>& decoders)
+{
+	for(auto w : m_waveformAreas)
+		w->OnDecodersRefreshed(decoders);
+}
+
 void OscilloscopeWindow::OnQuit()
 {
 	close();
@@ -634,13 +698,25 @@ WaveformArea* OscilloscopeWindow::DoAddChannel(OscilloscopeChannel* chan, Wavefo
 	return w;
 }
 
+/**
+	@brief Forgets about a protocol decoder that's about to be deleted
+ */
+void OscilloscopeWindow::RemoveDecoder(ProtocolDecoder* decode)
+{
+	m_decoderCache.RemoveDecoder(decode);
+	m_decoders.erase(decode);
+
+	//Don't let it take its output with it if a measurement is still looking at it
+	g_captureLeases.DetachIfLeased(decode);
+}
+
 void OscilloscopeWindow::OnRemoveChannel(WaveformArea* w)
 {
 	//If we're about to remove the last viewer for a protocol decoder, forget about it
 	auto chan = w->GetChannel();
 	auto decode = dynamic_cast<ProtocolDecoder*>(chan);
 	if(decode && (chan->GetRefCount() == 1) )
-		m_decoders.erase(decode);
+		RemoveDecoder(decode);
 
 	//Get rid of the channel
 	w->get_parent()->remove(*w);
@@ -651,39 +727,69 @@ void OscilloscopeWindow::OnRemoveChannel(WaveformArea* w)
 	GarbageCollectGroups();
 }
 
-void OscilloscopeWindow::PollScopes()
+/**
+	@brief Processes all waveforms the scope threads have ready
+
+	@param tsignal	Time at which the scope thread signaled that the first of them was ready, or zero if unknown
+ */
+void OscilloscopeWindow::PollScopes(double tsignal)
 {
+	if( (g_syncTolerance > 0) && (m_scopes.size() > 1) )
+	{
+		PollScopesSynchronized(tsignal);
+		return;
+	}
+
 	bool pending = true;
 	while(pending)
 	{
 		pending = false;
 
-		//TODO: better sync for multiple instruments (wait for all to trigger THEN download waveforms)
 		for(auto scope : m_scopes)
 		{
+			//See if the acquisition thread handed us anything.
+			//Don't ask the scope itself, that may have to wait for a download in progress to finish.
 			double start = GetTime();
-			Oscilloscope::TriggerMode status = scope->PollTriggerFifo();
-			if(status > Oscilloscope::TRIGGER_MODE_COUNT)
-			{
-				//Invalid value, skip it
-				continue;
-			}
+			size_t npending = g_waveformQueues.at(scope)->size();
 			m_tPoll += GetTime() - start;
-
-			//If triggered, grab the data
-			if(status != Oscilloscope::TRIGGER_MODE_TRIGGERED)
+			if(npending == 0)
 				continue;
 
-			//If we have a LOT of waveforms ready, don't waste time rendering all of them.
-			//Grab a big pile and only render the last.
-			//TODO: batch render with persistence?
-			if(scope->GetPendingWaveformCount() > 30)
+			//If we have a LOT of waveforms ready, let the backpressure policy decide which ones to draw.
+			//Skipped waveforms still go to views with persistence enabled, so they can accumulate the
+			//whole pile in one pass on the next frame.
+			auto policy = g_backpressurePolicies.at(scope);
+			bool render = false;
+			while(!render)
 			{
-				for(size_t i=0; i<25; i++)
-					OnWaveformDataReady(scope);
+				switch(policy->GetNextAction())
+				{
+					case BackpressurePolicy::ACTION_DROP:
+						DiscardWaveform(scope, false);
+						break;
+
+					case BackpressurePolicy::ACTION_SPILL:
+						DiscardWaveform(scope, true);
+						break;
+
+					case BackpressurePolicy::ACTION_SKIP:
+						OnWaveformDataReady(scope);
+						for(auto w : m_waveformAreas)
+						{
+							if(!w->IsPersistenceEnabled())
+								continue;
+							if( (w->GetChannel()->GetScope() == scope) || (w->GetChannel()->GetScope() == NULL) )
+								w->OnWaveformDataReady();
+						}
+						break;
+
+					case BackpressurePolicy::ACTION_RENDER:
+					default:
+						OnWaveformDataReady(scope);
+						render = true;
+						break;
+				}
 			}
-			else
-				OnWaveformDataReady(scope);
 
 			//Update the views
 			start = GetTime();
@@ -692,13 +798,19 @@ void OscilloscopeWindow::PollScopes()
 				if( (w->GetChannel()->GetScope() == scope) || (w->GetChannel()->GetScope() == NULL) )
 					w->OnWaveformDataReady();
 			}
-			m_tView += GetTime() - start;
+			double now = GetTime();
+			m_tView += now - start;
+
+			RecordLatency(tsignal, now);
+			tsignal = 0;
 
 			//If there's more waveforms pending, keep going
-			if(scope->HasPendingWaveforms())
+			if(!g_waveformQueues.at(scope)->empty())
 				pending = true;
 		}
 
+		UpdateBackpressureStatus();
+
 		//Process pending draw calls before we do another polling cycle
 		double start = GetTime();
 		while(Gtk::Main::events_pending())
@@ -709,46 +821,401 @@ void OscilloscopeWindow::PollScopes()
 
 void OscilloscopeWindow::OnWaveformDataReady(Oscilloscope* scope)
 {
-	//make sure we close fully
-	if(!is_visible())
-		m_historyWindow.close();
+	FetchWaveform(scope);
+
+	vector<Oscilloscope*> scopes;
+	scopes.push_back(scope);
+	OnWaveformsFetched(scopes);
+}
+
+/**
+	@brief Records how long it took from a waveform finishing downloading to the views being told about it
+
+	This doesn't include the time from the trigger to the end of the download, or the time to actually render.
+
+	@param tsignal	Time the scope thread signaled the waveform was ready, or zero if unknown
+	@param now		Time the views were marked dirty
+ */
+void OscilloscopeWindow::RecordLatency(double tsignal, double now)
+{
+	if(tsignal == 0)
+		return;
+
+	double latency = now - tsignal;
+	m_tLatency += latency;
+	m_tMaxLatency = max(m_tMaxLatency, latency);
+	m_latencyCount ++;
+}
+
+/**
+	@brief Processes waveforms from all scopes as one sync group.
+
+	Each scope's oldest waveform is staged, outside of its channels. Once every scope has one, the set is moved into
+	the channels and released to decode and render if all of their trigger timestamps are within g_syncTolerance of
+	each other. Otherwise the oldest waveform in the set can't have a partner (the other scopes have all moved past
+	it) so it's dropped and replaced with that scope's next one. Scopes with nothing pending keep their staged
+	waveform until the next call, or until it times out.
+ */
+void OscilloscopeWindow::PollScopesSynchronized(double tsignal)
+{
+	while(true)
+	{
+		//Stage a waveform from every scope that doesn't have one yet, wait for more if any have none
+		bool ready = true;
+		for(auto scope : m_scopes)
+		{
+			if(!StageWaveform(scope))
+				ready = false;
+		}
+		if(!ready)
+		{
+			UpdateBackpressureStatus();
+			ArmSyncTimeout();
+			break;
+		}
+
+		//Find the oldest and newest trigger in the set, relative to the first scope's so we don't lose precision
+		TimePoint ref = m_syncStaged[m_scopes[0]].m_trigger;
+		Oscilloscope* oldest = m_scopes[0];
+		double toldest = 0;
+		double tnewest = 0;
+		for(auto scope : m_scopes)
+		{
+			TimePoint tp = m_syncStaged[scope].m_trigger;
+			double t = (tp.first - ref.first) + (tp.second - ref.second) * 1e-12;
+			if(t < toldest)
+			{
+				oldest = scope;
+				toldest = t;
+			}
+			tnewest = max(tnewest, t);
+		}
+
+		//Too far apart, throw away the oldest and try again
+		if(tnewest - toldest > g_syncTolerance)
+		{
+			FreeStagedWaveform(m_syncStaged[oldest]);
+			m_syncStaged.erase(oldest);
+			m_syncUnmatched ++;
+			continue;
+		}
+
+		//Got a matched set, swap it in. The old data belongs to the history, so it's only detached.
+		bool render = false;
+		for(auto& it : m_syncStaged)
+		{
+			auto scope = it.first;
+			auto& staged = it.second;
+			for(size_t i=0; i<scope->GetChannelCount(); i++)
+			{
+				auto chan = scope->GetChannel(i);
+				chan->Detach();
+				chan->SetData(staged.m_data[i]);
+			}
+			render |= staged.m_render;
+		}
+		m_syncStaged.clear();
+		m_syncMatched ++;
+		OnWaveformsFetched(m_scopes);
+
+		//If every scope's backpressure policy said to skip this set, only views with persistence need it
+		double start = GetTime();
+		for(auto w : m_waveformAreas)
+		{
+			if(render || w->IsPersistenceEnabled())
+				w->OnWaveformDataReady();
+		}
+		double now = GetTime();
+		m_tView += now - start;
+
+		if(render)
+		{
+			RecordLatency(tsignal, now);
+			tsignal = 0;
+		}
+
+		UpdateBackpressureStatus();
+
+		//Process pending draw calls before we look for the next set
+		start = GetTime();
+		while(Gtk::Main::events_pending())
+			Gtk::Main::iteration();
+		m_tEvent += GetTime() - start;
+	}
+}
+
+/**
+	@brief Makes sure we get called back when the oldest staged waveform times out.
+
+	New waveforms only wake us up when a scope signals. If one scope misses a trigger that may never happen, and the
+	rest of the group would sit staged forever.
+ */
+void OscilloscopeWindow::ArmSyncTimeout()
+{
+	m_syncTimer.disconnect();
+	if(m_syncStaged.empty())
+		return;
+
+	double oldest = m_syncStaged.begin()->second.m_tStaged;
+	for(auto& it : m_syncStaged)
+		oldest = min(oldest, it.second.m_tStaged);
+
+	//Round up, and a little extra, so it has definitely expired when we look
+	double remaining = oldest + g_syncTimeout - GetTime();
+	unsigned int ms = max(0.0, ceil(remaining * 1000)) + 1;
+	m_syncTimer = Glib::signal_timeout().connect(sigc::mem_fun(*this, &OscilloscopeWindow::OnSyncTimeout), ms);
+}
 
+bool OscilloscopeWindow::OnSyncTimeout()
+{
+	//Re-arms itself if anything is still staged
+	PollScopesSynchronized(0);
+	return false;
+}
+
+/**
+	@brief Makes sure a scope has a waveform staged for the sync group, if it has any pending.
+
+	Each pending waveform goes through the scope's backpressure policy first, which may drop or spill it instead.
+	A staged waveform that has waited for its partners for more than g_syncTimeout is dropped and replaced.
+
+	@return True if the scope has a waveform staged
+ */
+bool OscilloscopeWindow::StageWaveform(Oscilloscope* scope)
+{
+	auto policy = g_backpressurePolicies.at(scope);
+	while(true)
+	{
+		auto it = m_syncStaged.find(scope);
+		if(it != m_syncStaged.end())
+		{
+			if(GetTime() - it->second.m_tStaged <= g_syncTimeout)
+				return true;
+
+			FreeStagedWaveform(it->second);
+			m_syncStaged.erase(it);
+			m_syncUnmatched ++;
+		}
+
+		double start = GetTime();
+		bool empty = g_waveformQueues.at(scope)->empty();
+		m_tPoll += GetTime() - start;
+		if(empty)
+			return false;
+
+		auto action = policy->GetNextAction();
+		switch(action)
+		{
+			case BackpressurePolicy::ACTION_DROP:
+				DiscardWaveform(scope, false);
+				break;
+
+			case BackpressurePolicy::ACTION_SPILL:
+				DiscardWaveform(scope, true);
+				break;
+
+			case BackpressurePolicy::ACTION_SKIP:
+			case BackpressurePolicy::ACTION_RENDER:
+			default:
+				{
+					//Fetch it, then put back what the channels were displaying
+					vector<CaptureChannelBase*> shown;
+					GetChannelData(scope, shown);
+					FetchWaveform(scope);
+
+					auto& staged = m_syncStaged[scope];
+					GetChannelData(scope, staged.m_data);
+					staged.m_trigger = GetTriggerTime(scope);
+					staged.m_tStaged = GetTime();
+					staged.m_render = (action != BackpressurePolicy::ACTION_SKIP);
+					for(size_t i=0; i<scope->GetChannelCount(); i++)
+					{
+						auto chan = scope->GetChannel(i);
+						chan->Detach();
+						chan->SetData(shown[i]);
+					}
+				}
+				break;
+		}
+	}
+}
+
+/**
+	@brief Frees a staged waveform that will never be displayed
+ */
+void OscilloscopeWindow::FreeStagedWaveform(StagedWaveform& staged)
+{
+	for(auto data : staged.m_data)
+		delete data;
+	staged.m_data.clear();
+}
+
+/**
+	@brief Gets the trigger timestamp of the waveform a scope's channels hold
+
+	Uses the first enabled channel with data, the same one the history window uses.
+ */
+TimePoint OscilloscopeWindow::GetTriggerTime(Oscilloscope* scope)
+{
+	for(size_t i=0; i<scope->GetChannelCount(); i++)
+	{
+		auto chan = scope->GetChannel(i);
+		auto data = chan->GetData();
+		if(chan->IsEnabled() && data)
+			return TimePoint(data->m_startTimestamp, data->m_startPicoseconds);
+	}
+	return TimePoint(0, 0);
+}
+
+/**
+	@brief Moves the oldest pending waveform from a scope's queue into its channels
+ */
+void OscilloscopeWindow::FetchWaveform(Oscilloscope* scope)
+{
 	//Make sure we don't free the old waveform data
 	//LogTrace("Detaching\n");
 	for(size_t i=0; i<scope->GetChannelCount(); i++)
 		scope->GetChannel(i)->Detach();
 
-	//Download the data
+	//Download the data. Every waveform in the scope's queue has a token in ours.
 	//LogTrace("Acquiring\n");
 	double start = GetTime();
+	WaveformToken token;
+	g_waveformQueues.at(scope)->Pop(token);
 	scope->AcquireDataFifo();
 	m_tAcquire += GetTime() - start;
 
+	//Keep the backpressure size estimate current
+	g_backpressurePolicies.at(scope)->OnWaveformAcquired();
+}
+
+/**
+	@brief Runs measurements, decodes and history on a set of waveforms that were just fetched.
+
+	Decoders only run once for the whole set, so decodes spanning several instruments see matching captures.
+ */
+void OscilloscopeWindow::OnWaveformsFetched(const vector<Oscilloscope*>& scopes)
+{
+	//make sure we close fully
+	if(!is_visible())
+		m_historyWindow.close();
+
 	//Update the status
 	UpdateStatusBar();
 
-	//Update the measurements
-	for(auto g : m_waveformGroups)
-		g->RefreshMeasurements();
-
-	//Update our protocol decoders
-	start = GetTime();
-	for(auto d : m_decoders)
-		d->SetDirty();
+	//Update our protocol decoders, and save the results in case we come back to this waveform from the history.
+	//Measurements still running on the last waveform keep the old outputs alive until they're done.
+	double start = GetTime();
+	m_decoderCache.Release(m_decoders);
 	for(auto d : m_decoders)
-		d->RefreshIfDirty();
+		g_captureLeases.DetachIfLeased(d);
+	m_decoderScheduler.RefreshAll(m_decoders);
+	OnDecodersRefreshed(m_decoders);
+	m_decoderCache.Store(m_decoders);
 	m_tDecode += GetTime() - start;
 
+	//Start the measurements now that everything they might look at is up to date
+	for(auto g : m_waveformGroups)
+		g->RefreshMeasurements();
+
 	//Update protocol analyzers
 	for(auto a : m_analyzers)
 		a->OnWaveformDataReady();
 
 	//Update the history window
-	m_historyWindow.OnWaveformDataReady(scope);
+	for(auto scope : scopes)
+		m_historyWindow.OnWaveformDataReady(scope);
 
 	m_tHistory += GetTime() - start;
 }
 
+/**
+	@brief Fetches the oldest pending waveform from a scope and throws it away without displaying it.
+
+	The channels are left showing whatever they were showing before.
+
+	@param scope	The scope to fetch from
+	@param spill	True to write the waveform to disk first
+ */
+void OscilloscopeWindow::DiscardWaveform(Oscilloscope* scope, bool spill)
+{
+	vector<CaptureChannelBase*> shown;
+	GetChannelData(scope, shown);
+	FetchWaveform(scope);
+	if(spill)
+		g_backpressurePolicies.at(scope)->SpillWaveform();
+	FreeWaveform(scope, shown);
+}
+
+/**
+	@brief Frees the waveform a scope's channels hold, for waveforms that were fetched but never displayed
+
+	@param scope	The scope
+	@param shown	What the channels held before the waveform was fetched, to put back
+ */
+void OscilloscopeWindow::FreeWaveform(Oscilloscope* scope, const vector<CaptureChannelBase*>& shown)
+{
+	for(size_t i=0; i<scope->GetChannelCount(); i++)
+	{
+		auto chan = scope->GetChannel(i);
+		delete chan->GetData();
+		chan->Detach();
+		chan->SetData(shown[i]);
+	}
+}
+
+/**
+	@brief Gets the capture each of a scope's channels currently holds (NULL for channels with none)
+ */
+void OscilloscopeWindow::GetChannelData(Oscilloscope* scope, vector<CaptureChannelBase*>& data)
+{
+	data.resize(scope->GetChannelCount());
+	for(size_t i=0; i<data.size(); i++)
+		data[i] = scope->GetChannel(i)->GetData();
+}
+
+/**
+	@brief Shows how many waveforms the backpressure policies have thrown away, if any
+ */
+void OscilloscopeWindow::UpdateBackpressureStatus()
+{
+	size_t dropped = 0;
+	size_t skipped = 0;
+	size_t spilled = 0;
+	for(auto scope : m_scopes)
+	{
+		auto policy = g_backpressurePolicies.at(scope);
+		dropped += policy->GetDroppedCount();
+		skipped += policy->GetSkippedCount();
+		spilled += policy->GetSpilledCount();
+	}
+
+	string str;
+	char tmp[128];
+	if(dropped)
+	{
+		snprintf(tmp, sizeof(tmp), "Dropped %zu  ", dropped);
+		str += tmp;
+	}
+	if(skipped)
+	{
+		snprintf(tmp, sizeof(tmp), "Skipped %zu  ", skipped);
+		str += tmp;
+	}
+	if(spilled)
+	{
+		snprintf(tmp, sizeof(tmp), "Spilled %zu  ", spilled);
+		str += tmp;
+	}
+	if(m_syncUnmatched)
+	{
+		snprintf(tmp, sizeof(tmp), "Unmatched %zu  ", m_syncUnmatched);
+		str += tmp;
+	}
+	if(m_backpressureLabel.get_label() != str)
+		m_backpressureLabel.set_label(str);
+}
+
 void OscilloscopeWindow::UpdateStatusBar()
 {
 	//TODO: redo this for multiple scopes
@@ -806,16 +1273,25 @@ void OscilloscopeWindow::OnHistoryUpdated()
 	//Stop triggering if we select a saved waveform
 	OnStop();
 
-	//Update the measurements
+	//Update our protocol decoders. Anything we've decoded this waveform with before is already in the cache.
+	double start = GetTime();
+	m_decoderCache.Release(m_decoders);
+	set<ProtocolDecoder*> misses;
+	for(auto d : m_decoders)
+	{
+		g_captureLeases.DetachIfLeased(d);
+		if(!m_decoderCache.Load(d))
+			misses.emplace(d);
+	}
+	m_decoderScheduler.RefreshAll(misses);
+	OnDecodersRefreshed(misses);
+	m_decoderCache.Store(misses);
+	m_tDecode += GetTime() - start;
+
+	//Start the measurements
 	for(auto g : m_waveformGroups)
 		g->RefreshMeasurements();
 
-	//Update our protocol decoders
-	for(auto d : m_decoders)
-		d->SetDirty();
-	for(auto d : m_decoders)
-		d->RefreshIfDirty();
-
 	//Update the views
 	for(auto w : m_waveformAreas)
 	{
@@ -828,6 +1304,8 @@ void OscilloscopeWindow::OnHistoryUpdated()
 
 void OscilloscopeWindow::RemoveHistory(TimePoint timestamp)
 {
+	m_decoderCache.RemoveTimePoint(timestamp);
+
 	for(auto a : m_analyzers)
 		a->RemoveHistory(timestamp);
 }
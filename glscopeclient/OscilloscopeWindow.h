@@ -41,6 +41,8 @@
 #include "WaveformGroup.h"
 #include "ProtocolAnalyzerWindow.h"
 #include "HistoryWindow.h"
+#include "DecoderCache.h"
+#include "DecoderScheduler.h"
 
 /**
 	@brief Main application window class for an oscilloscope
@@ -56,6 +58,8 @@ public:
 	void OnZoomOutHorizontal(WaveformGroup* group);
 	void ClearPersistence(WaveformGroup* group, bool dirty = true);
 	void ClearAllPersistence();
+	void OnChannelPropertiesChanged(OscilloscopeChannel* chan);
+	void OnDecodersRefreshed(const std::set<ProtocolDecoder*>& decoders);
 
 	void OnRemoveChannel(WaveformArea* w);
 
@@ -76,8 +80,7 @@ public:
 	void AddDecoder(ProtocolDecoder* decode)
 	{ m_decoders.emplace(decode); }
 
-	void RemoveDecoder(ProtocolDecoder* decode)
-	{ m_decoders.erase(decode); }
+	void RemoveDecoder(ProtocolDecoder* decode);
 
 	size_t GetScopeCount()
 	{ return m_scopes.size(); }
@@ -126,6 +129,7 @@ protected:
 	void OnRefreshConfig();
 
 	void UpdateStatusBar();
+	void UpdateBackpressureStatus();
 
 	//Initialization
 	void CreateWidgets();
@@ -176,11 +180,13 @@ public:
 	std::set<ProtocolAnalyzerWindow*> m_analyzers;
 
 	//Event handlers
-	void PollScopes();
+	void PollScopes(double tsignal = 0);
+	void PollScopesSynchronized(double tsignal);
 
 protected:
 	Gtk::HBox m_statusbar;
 		Gtk::Label m_triggerConfigLabel;
+		Gtk::Label m_backpressureLabel;
 
 	void OnEyeColorChanged(EyeColor color, Gtk::RadioMenuItem* item);
 
@@ -189,8 +195,48 @@ protected:
 	//Our scope connections
 	std::vector<Oscilloscope*> m_scopes;
 
+	DecoderScheduler m_decoderScheduler;
+	DecoderCache m_decoderCache;
+
 	//Status polling
 	void OnWaveformDataReady(Oscilloscope* scope);
+	void FetchWaveform(Oscilloscope* scope);
+	void OnWaveformsFetched(const std::vector<Oscilloscope*>& scopes);
+	void DiscardWaveform(Oscilloscope* scope, bool spill);
+	void FreeWaveform(Oscilloscope* scope, const std::vector<CaptureChannelBase*>& shown);
+	static void GetChannelData(Oscilloscope* scope, std::vector<CaptureChannelBase*>& data);
+	void RecordLatency(double tsignal, double now);
+	static TimePoint GetTriggerTime(Oscilloscope* scope);
+
+	/**
+		@brief A waveform fetched from a scope and held back from its channels until the rest of the sync group
+		has arrived, so nothing displays half of a set
+	 */
+	struct StagedWaveform
+	{
+		///@brief Capture for each channel, NULL if the channel has none
+		std::vector<CaptureChannelBase*> m_data;
+
+		///@brief Trigger time of the waveform
+		TimePoint m_trigger;
+
+		///@brief When it was staged, for timing out if its partners never show up
+		double m_tStaged;
+
+		///@brief False if the backpressure policy only wants it processed, not drawn
+		bool m_render;
+	};
+
+	bool StageWaveform(Oscilloscope* scope);
+	void FreeStagedWaveform(StagedWaveform& staged);
+	void ArmSyncTimeout();
+	bool OnSyncTimeout();
+
+	///@brief Waveforms waiting for the rest of the sync group
+	std::map<Oscilloscope*, StagedWaveform> m_syncStaged;
+
+	///@brief Fires when the oldest staged waveform times out
+	sigc::connection m_syncTimer;
 
 	double m_tArm;
 
@@ -207,6 +253,11 @@ protected:
 	double m_tHistory;
 	double m_tPoll;
 	double m_tEvent;
+	double m_tLatency;
+	double m_tMaxLatency;
+	size_t m_latencyCount;
+	size_t m_syncMatched;
+	size_t m_syncUnmatched;
 };
 
 #endif
@@ -0,0 +1,90 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of PixelBuffer
+ */
+#ifndef PixelBuffer_h
+#define PixelBuffer_h
+
+/**
+	@brief An OpenGL pixel unpack buffer, for streaming texture uploads.
+
+	Each Map() orphans the previous contents, so the driver can keep DMAing the last upload into its texture while
+	we fill the next one and glTexSubImage2D() from the buffer returns without waiting for the copy.
+ */
+class PixelBuffer
+{
+public:
+	PixelBuffer()
+	: m_handle(0)
+	{}
+
+	~PixelBuffer()
+	{ Destroy(); }
+
+	void Destroy()
+	{
+		if(m_handle != 0)
+			glDeleteBuffers(1, &m_handle);
+		m_handle = 0;
+	}
+
+	operator GLuint() const
+	{ return m_handle; }
+
+	void Bind()
+	{
+		LazyInit();
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_handle);
+	}
+
+	static void Unbind()
+	{ glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); }
+
+	void* Map(size_t size);
+	void Unmap();
+
+protected:
+
+	/**
+		@brief Lazily creates the PBO
+	 */
+	void LazyInit()
+	{
+		if(!m_handle)
+			glGenBuffers(1, &m_handle);
+	}
+
+	GLuint	m_handle;
+};
+
+#endif
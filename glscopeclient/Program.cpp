@@ -67,6 +67,9 @@ void Program::Add(Shader& shader)
 
 bool Program::Link()
 {
+	//Allow the linked binary to be saved in case someone wants to cache it
+	glProgramParameteri(m_handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
 	glLinkProgram(m_handle);
 
 	int status;
@@ -82,3 +85,38 @@ bool Program::Link()
 
 	return false;
 }
+
+/**
+	@brief Gets the driver-specific binary of a linked program, for use with LoadBinary() later on
+ */
+bool Program::GetBinary(GLenum& format, vector<uint8_t>& data)
+{
+	GLint len = 0;
+	glGetProgramiv(m_handle, GL_PROGRAM_BINARY_LENGTH, &len);
+	if(len <= 0)
+		return false;
+
+	data.resize(len);
+	GLsizei written = 0;
+	glGetProgramBinary(m_handle, len, &written, &format, &data[0]);
+	data.resize(written);
+	return (written > 0);
+}
+
+/**
+	@brief Loads a previously linked program binary instead of compiling and linking shaders.
+
+	Drivers reject binaries from other driver versions or hardware, so this can fail at any time and the caller
+	must be prepared to fall back to compiling.
+ */
+bool Program::LoadBinary(GLenum format, const vector<uint8_t>& data)
+{
+	if(m_handle == 0)
+		m_handle = glCreateProgram();
+
+	glProgramBinary(m_handle, format, &data[0], data.size());
+
+	int status;
+	glGetProgramiv(m_handle, GL_LINK_STATUS, &status);
+	return (status == GL_TRUE);
+}
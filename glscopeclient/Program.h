@@ -50,6 +50,9 @@ public:
 
 	void Add(Shader& shader);
 
+	bool GetBinary(GLenum& format, std::vector<uint8_t>& data);
+	bool LoadBinary(GLenum format, const std::vector<uint8_t>& data);
+
 	operator GLuint()
 	{ return m_handle; }
 
@@ -111,12 +114,18 @@ public:
 		glUniform1i(GetUniformLocation(name), texid);
 	}
 
-	void SetImageUniform(Texture& tex, const char* name, int texid = 0)
+	void SetUniformVec3Array(const float* values, size_t count, const char* name)
+	{ glUniform3fv(GetUniformLocation(name), count, values); }
+
+	void SetImageUniform(Texture& tex, const char* name, int texid = 0, GLenum format = GL_RGBA32F)
 	{
 		glActiveTexture(GL_TEXTURE0 + texid);
 		tex.Bind();
 		glUniform1i(GetUniformLocation(name), texid);
-		glBindImageTexture(texid, tex, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
+
+		//Texture arrays are bound as a whole, so the shader can pick the layer
+		GLboolean layered = (tex.GetTarget() == GL_TEXTURE_2D_ARRAY) ? GL_TRUE : GL_FALSE;
+		glBindImageTexture(texid, tex, 0, layered, 0, GL_READ_WRITE, format);
 	}
 
 	void DispatchCompute(GLuint x, GLuint y, GLuint z)
@@ -0,0 +1,245 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of ProgramBinaryCache
+ */
+#include "glscopeclient.h"
+#include "ProgramBinaryCache.h"
+#include <cinttypes>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+//Marks the start of a cache file, bump the last digit if the layout changes
+#define CACHE_MAGIC 0x31425047
+
+/**
+	@brief Header at the start of each cache file, followed by the binary itself
+ */
+struct ProgramBinaryHeader
+{
+	uint32_t	magic;
+	uint32_t	format;
+	uint64_t	hash;
+};
+
+ProgramBinaryCache::ProgramBinaryCache()
+	: m_hits(0)
+	, m_misses(0)
+{
+	//If the driver can't give us any binaries, there's no point
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	if(formats == 0)
+	{
+		LogDebug("GL driver doesn't support program binaries, shader cache disabled\n");
+		return;
+	}
+
+	//Figure out where to put the cache, and create it if needed
+	const char* base = getenv("XDG_CACHE_HOME");
+	string dir;
+	if( (base != NULL) && (base[0] != '\0') )
+		dir = base;
+	else
+	{
+		const char* home = getenv("HOME");
+		if(home == NULL)
+			return;
+		dir = string(home) + "/.cache";
+		mkdir(dir.c_str(), 0700);
+	}
+	dir += "/glscopeclient";
+	if( (0 != mkdir(dir.c_str(), 0700)) && (errno != EEXIST) )
+	{
+		LogWarning("Couldn't create shader cache directory %s, shader cache disabled\n", dir.c_str());
+		return;
+	}
+	m_dir = dir;
+
+	m_driver =
+		string(reinterpret_cast<const char*>(glGetString(GL_VENDOR))) + "\n" +
+		reinterpret_cast<const char*>(glGetString(GL_RENDERER)) + "\n" +
+		reinterpret_cast<const char*>(glGetString(GL_VERSION));
+}
+
+/**
+	@brief Loads a program from the cache, or compiles and links it (and saves the result for next time).
+
+	@param prog		The program to load. Must not have any shaders attached yet.
+	@param shaders	Type and source file path of each shader in the program
+
+	@return True on success, false if the shaders could not be read, compiled, or linked
+ */
+bool ProgramBinaryCache::Load(Program& prog, const vector<pair<GLenum, string> >& shaders)
+{
+	vector<string> sources;
+	for(auto& s : shaders)
+	{
+		string source;
+		if(!Shader::ReadSource(s.second, source))
+			return false;
+		sources.push_back(source);
+	}
+
+	uint64_t hash = Hash(sources);
+	if(LoadBinary(prog, hash))
+	{
+		m_hits ++;
+		return true;
+	}
+	m_misses ++;
+
+	//Not in the cache (or the driver didn't like it), do it the slow way
+	for(size_t i=0; i<shaders.size(); i++)
+	{
+		Shader shader(shaders[i].first);
+		if(!shader.Compile(sources[i], shaders[i].second))
+			return false;
+		prog.Add(shader);
+	}
+	if(!prog.Link())
+		return false;
+
+	StoreBinary(prog, hash);
+	return true;
+}
+
+/**
+	@brief 64-bit FNV-1a hash of the driver identification and all shader sources
+ */
+uint64_t ProgramBinaryCache::Hash(const vector<string>& sources)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	auto mix = [&hash](const string& s)
+	{
+		for(auto c : s)
+		{
+			hash ^= static_cast<uint8_t>(c);
+			hash *= 0x100000001b3ULL;
+		}
+
+		//Separator so moving text between strings changes the hash
+		hash ^= 0xff;
+		hash *= 0x100000001b3ULL;
+	};
+
+	mix(m_driver);
+	for(auto& s : sources)
+		mix(s);
+	return hash;
+}
+
+string ProgramBinaryCache::GetPath(uint64_t hash)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "/%016" PRIx64 ".bin", hash);
+	return m_dir + name;
+}
+
+bool ProgramBinaryCache::LoadBinary(Program& prog, uint64_t hash)
+{
+	if(m_dir.empty())
+		return false;
+
+	FILE* fp = fopen(GetPath(hash).c_str(), "rb");
+	if(!fp)
+		return false;
+
+	ProgramBinaryHeader header;
+	vector<uint8_t> data;
+	bool ok = (1 == fread(&header, sizeof(header), 1, fp));
+	if(ok)
+		ok = (header.magic == CACHE_MAGIC) && (header.hash == hash);
+	if(ok)
+	{
+		fseek(fp, 0, SEEK_END);
+		long len = ftell(fp) - sizeof(header);
+		fseek(fp, sizeof(header), SEEK_SET);
+		ok = (len > 0);
+		if(ok)
+		{
+			data.resize(len);
+			ok = (data.size() == fread(&data[0], 1, data.size(), fp));
+		}
+	}
+	fclose(fp);
+
+	if(!ok)
+	{
+		LogDebug("Ignoring corrupted shader cache file %s\n", GetPath(hash).c_str());
+		return false;
+	}
+
+	if(!prog.LoadBinary(header.format, data))
+	{
+		LogDebug("GL driver rejected cached shader binary %s, recompiling\n", GetPath(hash).c_str());
+		return false;
+	}
+	return true;
+}
+
+void ProgramBinaryCache::StoreBinary(Program& prog, uint64_t hash)
+{
+	if(m_dir.empty())
+		return;
+
+	GLenum format;
+	vector<uint8_t> data;
+	if(!prog.GetBinary(format, data))
+		return;
+
+	ProgramBinaryHeader header;
+	header.magic = CACHE_MAGIC;
+	header.format = format;
+	header.hash = hash;
+
+	//Write to a temporary file and rename it, so another instance starting at the same time never sees half a file
+	string path = GetPath(hash);
+	string tmp = path + "." + to_string(getpid());
+	FILE* fp = fopen(tmp.c_str(), "wb");
+	if(!fp)
+		return;
+	bool ok =
+		(1 == fwrite(&header, sizeof(header), 1, fp)) &&
+		(data.size() == fwrite(&data[0], 1, data.size(), fp));
+	ok = (0 == fclose(fp)) && ok;
+
+	if(!ok || (0 != rename(tmp.c_str(), path.c_str())) )
+	{
+		LogWarning("Couldn't write shader cache file %s\n", path.c_str());
+		unlink(tmp.c_str());
+	}
+}
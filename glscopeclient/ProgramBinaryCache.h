@@ -0,0 +1,76 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of ProgramBinaryCache
+ */
+#ifndef ProgramBinaryCache_h
+#define ProgramBinaryCache_h
+
+/**
+	@brief On-disk cache of linked shader programs, so later launches can skip the driver's compiler.
+
+	Binaries live in $XDG_CACHE_HOME/glscopeclient (or ~/.cache/glscopeclient), one file per program, named by a
+	hash of the shader sources plus the GL vendor, renderer, and version strings. A driver update therefore misses
+	the cache rather than loading a stale binary, and a binary the driver rejects anyway is simply recompiled.
+
+	Must be created and used with a GL context current.
+ */
+class ProgramBinaryCache
+{
+public:
+	ProgramBinaryCache();
+
+	bool Load(Program& prog, const std::vector<std::pair<GLenum, std::string> >& shaders);
+
+	size_t GetHitCount()
+	{ return m_hits; }
+
+	size_t GetMissCount()
+	{ return m_misses; }
+
+protected:
+	uint64_t Hash(const std::vector<std::string>& sources);
+	bool LoadBinary(Program& prog, uint64_t hash);
+	void StoreBinary(Program& prog, uint64_t hash);
+	std::string GetPath(uint64_t hash);
+
+	///@brief Directory binaries are stored in (empty if caching is disabled)
+	std::string m_dir;
+
+	///@brief Identifies the driver the binaries were built by
+	std::string m_driver;
+
+	size_t m_hits;
+	size_t m_misses;
+};
+
+#endif
@@ -0,0 +1,131 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of SPSCQueue
+ */
+#ifndef SPSCQueue_h
+#define SPSCQueue_h
+
+#include <atomic>
+
+//Size of a cache line, for keeping the producer and consumer indexes from false sharing
+#define SPSC_CACHE_LINE	64
+
+/**
+	@brief Bounded lock-free queue with one producer thread and one consumer thread.
+
+	The head index is only written by the consumer and the tail only by the producer, each on its own cache line.
+	Each side also keeps a private copy of the other side's index and only re-reads the shared one when the copy
+	says the queue is full (or empty), so in steady state a push or pop touches no cache line owned by the other
+	thread.
+
+	N must be a power of two. Indexes count up forever and are masked on access.
+ */
+template<class T, size_t N>
+class SPSCQueue
+{
+public:
+	static_assert( (N & (N-1)) == 0, "SPSCQueue size must be a power of two");
+
+	SPSCQueue()
+	: m_head(0)
+	, m_cachedTail(0)
+	, m_tail(0)
+	, m_cachedHead(0)
+	{}
+
+	/**
+		@brief Adds an item. Producer thread only.
+
+		@return False if the queue is full
+	 */
+	bool Push(const T& item)
+	{
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		if(tail - m_cachedHead == N)
+		{
+			m_cachedHead = m_head.load(std::memory_order_acquire);
+			if(tail - m_cachedHead == N)
+				return false;
+		}
+
+		m_data[tail & (N-1)] = item;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+		@brief Removes the oldest item. Consumer thread only.
+
+		@return False if the queue is empty
+	 */
+	bool Pop(T& item)
+	{
+		size_t head = m_head.load(std::memory_order_relaxed);
+		if(head == m_cachedTail)
+		{
+			m_cachedTail = m_tail.load(std::memory_order_acquire);
+			if(head == m_cachedTail)
+				return false;
+		}
+
+		item = m_data[head & (N-1)];
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+		@brief Number of items in the queue. Exact from either end's own thread, a snapshot from anywhere else.
+	 */
+	size_t size() const
+	{ return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+
+	bool empty() const
+	{ return size() == 0; }
+
+protected:
+
+	//Each side's fields start on their own cache line, and the data starts on the next one.
+	//(Even if the queue itself isn't allocated on a line boundary, the two index fields are a full line apart.)
+
+	//Consumer side
+	alignas(SPSC_CACHE_LINE) std::atomic<size_t> m_head;
+	size_t m_cachedTail;
+
+	//Producer side
+	alignas(SPSC_CACHE_LINE) std::atomic<size_t> m_tail;
+	size_t m_cachedHead;
+
+	alignas(SPSC_CACHE_LINE) T m_data[N];
+};
+
+#endif
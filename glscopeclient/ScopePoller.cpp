@@ -0,0 +1,165 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of ScopePoller
+ */
+#include "glscopeclient.h"
+#include "ScopePoller.h"
+#include "BackpressurePolicy.h"
+
+using namespace std;
+
+extern WaveformNotifier* g_waveformNotifier;
+
+//Polling interval limits, in microseconds
+#define POLL_DELAY_MIN		250
+#define POLL_DELAY_MAX		(500 * 1000)
+
+//How long to back off for when we don't want to poll at all
+#define POLL_DELAY_IDLE		(50 * 1000)
+
+ScopePoller::ScopePoller(Oscilloscope* scope, WaveformQueue* queue, BackpressurePolicy* policy)
+	: m_scope(scope)
+	, m_queue(queue)
+	, m_policy(policy)
+	, m_delay(1000)
+	, m_tlast(GetTime())
+	, m_npolls(0)
+	, m_dt(0)
+	, m_tokenPending(false)
+{
+	m_pendingToken.m_tAcquired = 0;
+}
+
+/**
+	@brief Polls the trigger once, and acquires a waveform if we triggered
+
+	@return Time to wait before calling Poll() again, in microseconds
+ */
+uint32_t ScopePoller::Poll()
+{
+	//If the UI's queue was full last time, the waveform is still in the scope's queue without a token.
+	//Don't acquire anything else until the token is handed over, so the UI can't lose track of it.
+	if(m_tokenPending)
+	{
+		if(!m_queue->Push(m_pendingToken))
+		{
+			m_tlast = GetTime();
+			return POLL_DELAY_IDLE;
+		}
+		m_tokenPending = false;
+		g_waveformNotifier->Signal();
+	}
+
+	//If we've gotten too far ahead of the UI, wait for a while before polling any more
+	if(m_policy->ShouldPause(m_dt))
+	{
+		m_tlast = GetTime();
+		return POLL_DELAY_IDLE;
+	}
+
+	//If trigger isn't armed, don't even bother polling for a while.
+	if(!m_scope->IsTriggerArmed())
+	{
+		m_tlast = GetTime();
+		return POLL_DELAY_IDLE;
+	}
+
+	auto stat = m_scope->PollTrigger();
+
+	if(stat == Oscilloscope::TRIGGER_MODE_TRIGGERED)
+	{
+		//Collect the data, fail if that doesn't work
+		if(!m_scope->AcquireData(true))
+		{
+			m_tlast = GetTime();
+			return 0;
+		}
+
+		//Hand it to the UI thread and wake it up
+		double now = GetTime();
+		WaveformToken token = { now };
+		if(!m_queue->Push(token))
+		{
+			LogWarning("Waveform queue for %s is full, pausing until the UI catches up\n",
+				m_scope->m_nickname.c_str());
+			m_pendingToken = token;
+			m_tokenPending = true;
+		}
+		g_waveformNotifier->Signal();
+
+		//Measure how long the acquisition took
+		m_dt = now - m_tlast;
+		m_tlast = now;
+
+		//Adjust polling interval so that we poll a handful of times between triggers
+		if(m_npolls > 5)
+		{
+			m_delay *= 1.5;
+
+			//Don't increase poll interval beyond 500ms. If we hit that point the scope is either insanely slow,
+			//or they're targeting some kind of intermittent signal. Don't add more lag on top of that!
+			if(m_delay > POLL_DELAY_MAX)
+				m_delay = POLL_DELAY_MAX;
+		}
+		if(m_npolls < 2)
+		{
+			m_delay /= 1.5;
+			if(m_delay < POLL_DELAY_MIN)
+				m_delay = POLL_DELAY_MIN;
+		}
+
+		//If we have a really high trigger latency (super low bandwidth link?)
+		//then force the delay to be a bit higher so we have time for other threads to get to the scope
+		if(m_dt > 2000)
+		{
+			if(m_delay < 5000)
+				m_delay = 5000;
+		}
+
+		m_npolls = 0;
+		return 0;
+	}
+	m_npolls ++;
+
+	//We didn't trigger. Wait a while before the next time we poll to avoid hammering slower hardware.
+	uint32_t delay = m_delay;
+
+	//If we've polled a ton of times and the delay is tiny, do a big step increase
+	if(m_npolls > 50)
+	{
+		m_delay *= 10;
+		m_npolls = 0;
+	}
+
+	return delay;
+}
@@ -0,0 +1,103 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of ScopePoller
+ */
+#ifndef ScopePoller_h
+#define ScopePoller_h
+
+#include "SPSCQueue.h"
+
+/**
+	@brief Handed from a scope's acquisition thread to the UI for each waveform it downloads.
+
+	The waveform itself sits in the scope's own pending queue. The UI pops one of these before each AcquireDataFifo()
+	so it can tell whether there's anything to fetch without taking the scope's locks, which may be held for the
+	whole of a long download.
+ */
+struct WaveformToken
+{
+	///@brief Time at which the waveform finished downloading
+	double m_tAcquired;
+};
+
+///@brief Maximum number of waveforms in flight per instrument, must be more than ScopePoller lets queue up
+typedef SPSCQueue<WaveformToken, 8192> WaveformQueue;
+
+class BackpressurePolicy;
+
+/**
+	@brief Polling state machine for one instrument: poll trigger, acquire, enqueue.
+
+	Each call to Poll() does one step and says how long to wait before the next one. Adapts the polling interval so
+	we poll a handful of times between triggers without hammering slower hardware. Shared by the thread-per-scope
+	loop and the AcquisitionReactor, which just differ in how they wait.
+ */
+class ScopePoller
+{
+public:
+	ScopePoller(Oscilloscope* scope, WaveformQueue* queue, BackpressurePolicy* policy);
+
+	uint32_t Poll();
+
+	Oscilloscope* GetScope()
+	{ return m_scope; }
+
+protected:
+	Oscilloscope* m_scope;
+
+	///@brief Tokens for waveforms we've downloaded and the UI hasn't picked up yet
+	WaveformQueue* m_queue;
+
+	///@brief Decides when the UI is too far behind for us to keep triggering
+	BackpressurePolicy* m_policy;
+
+	///@brief Current delay between trigger polls, in microseconds
+	uint32_t m_delay;
+
+	///@brief Time of the last acquisition
+	double m_tlast;
+
+	///@brief Number of polls since the last trigger
+	size_t m_npolls;
+
+	///@brief Time between the last two acquisitions
+	double m_dt;
+
+	///@brief True if the last waveform's token didn't fit in m_queue and still has to be pushed
+	bool m_tokenPending;
+
+	///@brief The token that didn't fit
+	WaveformToken m_pendingToken;
+};
+
+#endif
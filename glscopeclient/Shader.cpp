@@ -52,7 +52,17 @@ Shader::~Shader()
 
 bool Shader::Load(string path)
 {
-	//Read the file
+	string source;
+	if(!ReadSource(path, source))
+		return false;
+	return Compile(source, path);
+}
+
+/**
+	@brief Reads a shader source file into a string
+ */
+bool Shader::ReadSource(string path, string& source)
+{
 	FILE* fp = fopen(path.c_str(), "rb");
 	if(!fp)
 	{
@@ -62,18 +72,26 @@ bool Shader::Load(string path)
 	fseek(fp, 0, SEEK_END);
 	size_t fsize = ftell(fp);
 	fseek(fp, 0, SEEK_SET);
-	char* buf = new char[fsize + 1];
-	if(fsize != fread(buf, 1, fsize, fp))
+	source.resize(fsize);
+	if(fsize != fread(&source[0], 1, fsize, fp))
 	{
 		LogWarning("Shader::Load: Could not read file \"%s\"\n", path.c_str());
-		delete[] buf;
 		fclose(fp);
 		return false;
 	}
-	buf[fsize] = 0;
 	fclose(fp);
+	return true;
+}
 
-	//Compile the shader
+/**
+	@brief Compiles the shader from source already in memory
+
+	@param source	GLSL source
+	@param name		Name of the shader for error messages
+ */
+bool Shader::Compile(const string& source, const string& name)
+{
+	const char* buf = source.c_str();
 	glShaderSource(m_handle, 1, &buf, NULL);
 	glCompileShader(m_handle);
 
@@ -81,18 +99,14 @@ bool Shader::Load(string path)
 	int status;
 	glGetShaderiv(m_handle, GL_COMPILE_STATUS, &status);
 	if(status == GL_TRUE)
-	{
-		delete[] buf;
 		return true;
-	}
 
 	//Compile failed, return error
 	char log[4096];
 	int len;
 	glGetShaderInfoLog(m_handle, sizeof(log), &len, log);
-	LogError("Compile of shader %s failed:\n%s\n", path.c_str(), log);
+	LogError("Compile of shader %s failed:\n%s\n", name.c_str(), log);
 	LogNotice("Shader source: %s\n", buf);
 
-	delete[] buf;
 	return false;
 }
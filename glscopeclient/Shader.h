@@ -45,6 +45,9 @@ public:
 	virtual ~Shader();
 
 	bool Load(std::string path);
+	bool Compile(const std::string& source, const std::string& name);
+
+	static bool ReadSource(std::string path, std::string& source);
 
 	operator GLuint()
 	{ return m_handle; }
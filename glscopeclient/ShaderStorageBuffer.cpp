@@ -48,3 +48,121 @@ void ShaderStorageBuffer::BulkInit(vector<ShaderStorageBuffer*>& arr)
 
 	delete[] p;
 }
+
+void ShaderStorageBuffer::Destroy()
+{
+	for(int i=0; i<RING_SEGMENTS; i++)
+	{
+		if(m_fences[i])
+			glDeleteSync(m_fences[i]);
+		m_fences[i] = 0;
+	}
+
+	if(m_mapping)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+	}
+	m_mapping = NULL;
+	m_segmentStride = 0;
+	m_segmentSize = 0;
+
+	if(m_handle != 0)
+		glDeleteBuffers(1, &m_handle);
+	m_handle = 0;
+}
+
+/**
+	@brief Advances to the next segment of the ring and returns a pointer the CPU can write it through.
+
+	Blocks if the GPU has not yet finished with the previous contents of that segment. The returned memory is
+	coherent, so no flush is needed before using the buffer. Call FenceRingSegment() after submitting the last
+	command that reads from the segment.
+
+	@param size		Number of bytes needed
+ */
+void* ShaderStorageBuffer::MapRingSegment(size_t size)
+{
+	//Zero-size bindings aren't legal, always keep at least one element around
+	if(size == 0)
+		size = sizeof(float);
+
+	//Buffer storage is immutable, so it has to be recreated to grow
+	if(size > m_segmentStride)
+		ReallocateRing(size);
+	else
+		m_segment = (m_segment + 1) % RING_SEGMENTS;
+
+	//Wait for the GPU to be done with whatever was here last time around
+	GLsync& fence = m_fences[m_segment];
+	if(fence)
+	{
+		while(true)
+		{
+			GLenum ret = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			if( (ret == GL_ALREADY_SIGNALED) || (ret == GL_CONDITION_SATISFIED) )
+				break;
+			if(ret == GL_WAIT_FAILED)
+			{
+				LogError("glClientWaitSync failed\n");
+				break;
+			}
+		}
+		glDeleteSync(fence);
+		fence = 0;
+	}
+
+	m_segmentSize = size;
+	return m_mapping + m_segment*m_segmentStride;
+}
+
+/**
+	@brief Marks the current segment as in use by all GPU commands submitted so far
+ */
+void ShaderStorageBuffer::FenceRingSegment()
+{
+	if(!m_mapping)
+		return;
+
+	GLsync& fence = m_fences[m_segment];
+	if(fence)
+		glDeleteSync(fence);
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/**
+	@brief Throws out the current buffer and creates a persistently mapped ring with segments of at least the given size
+ */
+void ShaderStorageBuffer::ReallocateRing(size_t size)
+{
+	//Segments have to start on a legal binding offset
+	static GLint align = 0;
+	if(align == 0)
+	{
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &align);
+		if(align <= 0)
+			align = 256;
+	}
+
+	//Grow geometrically so slowly increasing sizes (e.g. zooming in) don't reallocate every frame
+	size_t stride = max(size, m_segmentStride * 2);
+	stride = ( (stride + align - 1) / align ) * align;
+
+	//The old storage may still be in use by the GPU, but deleting it is deferred by the driver until it's idle
+	Destroy();
+	LazyInit();
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_handle);
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glBufferStorage(GL_SHADER_STORAGE_BUFFER, stride * RING_SEGMENTS, NULL, flags);
+	m_mapping = reinterpret_cast<uint8_t*>(
+		glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, stride * RING_SEGMENTS, flags));
+	if(!m_mapping)
+	{
+		LogError("Failed to map shader storage buffer\n");
+		exit(1);
+	}
+
+	m_segmentStride = stride;
+	m_segment = 0;
+}
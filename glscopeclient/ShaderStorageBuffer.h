@@ -38,6 +38,10 @@
 /**
 	@brief An OpenGL SSBO.
 
+	Buffers are normally filled with glBufferData(), but can also be used as a persistently mapped ring of
+	RING_SEGMENTS segments (see MapRingSegment()). In ring mode the CPU writes straight into one segment while the
+	GPU may still be reading the previous ones, and BindBase() binds only the most recently mapped segment.
+
 	No virtual functions allowed, must be a POD type.
  */
 class ShaderStorageBuffer
@@ -45,17 +49,19 @@ class ShaderStorageBuffer
 public:
 	ShaderStorageBuffer()
 	: m_handle(0)
-	{}
+	, m_mapping(NULL)
+	, m_segmentStride(0)
+	, m_segment(0)
+	, m_segmentSize(0)
+	{
+		for(int i=0; i<RING_SEGMENTS; i++)
+			m_fences[i] = 0;
+	}
 
 	~ShaderStorageBuffer()
 	{ Destroy(); }
 
-	void Destroy()
-	{
-		if(m_handle != 0)
-			glDeleteBuffers(1, &m_handle);
-		m_handle = 0;
-	}
+	void Destroy();
 
 	operator GLuint() const
 	{ return m_handle; }
@@ -67,10 +73,21 @@ public:
 	}
 
 	void BindBase(GLuint i)
-	{ glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, m_handle); }
+	{
+		if(m_mapping)
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, i, m_handle, m_segment*m_segmentStride, m_segmentSize);
+		else
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, m_handle);
+	}
+
+	void* MapRingSegment(size_t size);
+	void FenceRingSegment();
 
 	static void BulkInit(std::vector<ShaderStorageBuffer*>& arr);
 
+	///@brief Number of segments in a ring (one being written, up to two in flight on the GPU)
+	enum { RING_SEGMENTS = 3 };
+
 protected:
 
 	/**
@@ -82,7 +99,24 @@ protected:
 			glGenBuffers(1, &m_handle);
 	}
 
+	void ReallocateRing(size_t size);
+
 	GLuint	m_handle;
+
+	///@brief Base of the persistent mapping (NULL if not in ring mode)
+	uint8_t* m_mapping;
+
+	///@brief Distance between the start of consecutive segments, in bytes
+	size_t m_segmentStride;
+
+	///@brief Index of the most recently mapped segment
+	int m_segment;
+
+	///@brief Number of bytes in use in the most recently mapped segment
+	size_t m_segmentSize;
+
+	///@brief Fences signaled when the GPU is done reading each segment
+	GLsync m_fences[RING_SEGMENTS];
 };
 
 #endif
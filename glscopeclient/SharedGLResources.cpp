@@ -0,0 +1,189 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of SharedGLResources
+ */
+#include "glscopeclient.h"
+#include "OscilloscopeWindow.h"
+#include "SharedGLResources.h"
+
+using namespace std;
+
+extern bool g_gpuGeometry;
+
+map<GdkGLContext*, SharedGLResources*> SharedGLResources::m_instances;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Construction / destruction
+
+SharedGLResources::SharedGLResources(GdkGLContext* key)
+	: m_key(key)
+	, m_refcount(1)
+{
+	double start = GetTime();
+
+	ProgramBinaryCache cache;
+	InitializeWaveformPrograms(cache);
+	InitializeColormapProgram(cache);
+	InitializeEyeProgram(cache);
+	InitializeCairoProgram(cache);
+	LoadEyeColorRamps();
+
+	LogDebug("Loaded shaders (%zu from cache, %zu compiled) and color ramps in %.3f ms\n",
+		cache.GetHitCount(), cache.GetMissCount(), (GetTime() - start) * 1000);
+}
+
+SharedGLResources::~SharedGLResources()
+{
+	m_instances.erase(m_key);
+}
+
+/**
+	@brief Gets the resources shared by everything in the same share group as the given context, creating them if
+	this is the first one.
+
+	The context must be current.
+ */
+SharedGLResources* SharedGLResources::Acquire(Glib::RefPtr<Gdk::GLContext> context)
+{
+	//GLAreas share with their window's paint context. If there is none, we can only share with ourself.
+	GdkGLContext* key = gdk_gl_context_get_shared_context(context->gobj());
+	if(key == NULL)
+		key = context->gobj();
+
+	auto it = m_instances.find(key);
+	if(it != m_instances.end())
+	{
+		it->second->m_refcount ++;
+		return it->second;
+	}
+
+	auto res = new SharedGLResources(key);
+	m_instances[key] = res;
+	return res;
+}
+
+/**
+	@brief Drops one reference, freeing everything once the last user is gone.
+
+	A context in the same share group must be current.
+ */
+void SharedGLResources::Release()
+{
+	m_refcount --;
+	if(m_refcount == 0)
+		delete this;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Loading
+
+void SharedGLResources::InitializeWaveformPrograms(ProgramBinaryCache& cache)
+{
+	if(!cache.Load(m_waveformComputeProgram, {{GL_COMPUTE_SHADER, "shaders/waveform-compute.glsl"}}))
+	{
+		LogError("failed to load waveform compute shader, aborting");
+		exit(1);
+	}
+
+	//Transform and indexing shaders are only needed if we're computing geometry on the GPU
+	if(!g_gpuGeometry)
+		return;
+
+	if(!cache.Load(m_waveformTransformProgram, {{GL_COMPUTE_SHADER, "shaders/waveform-transform-compute.glsl"}}) ||
+		!cache.Load(m_waveformIndexProgram, {{GL_COMPUTE_SHADER, "shaders/waveform-index-compute.glsl"}}) )
+	{
+		LogError("failed to load waveform transform shaders, aborting");
+		exit(1);
+	}
+}
+
+void SharedGLResources::InitializeColormapProgram(ProgramBinaryCache& cache)
+{
+	if(!cache.Load(m_colormapProgram, {
+		{GL_VERTEX_SHADER, "shaders/colormap-vertex.glsl"},
+		{GL_FRAGMENT_SHADER, "shaders/colormap-fragment.glsl"}}))
+	{
+		LogError("failed to load colormap shaders, aborting");
+		exit(1);
+	}
+}
+
+void SharedGLResources::InitializeEyeProgram(ProgramBinaryCache& cache)
+{
+	if(!cache.Load(m_eyeProgram, {
+		{GL_VERTEX_SHADER, "shaders/eye-vertex.glsl"},
+		{GL_FRAGMENT_SHADER, "shaders/eye-fragment.glsl"}}))
+	{
+		LogError("failed to load eye shaders, aborting");
+		exit(1);
+	}
+}
+
+void SharedGLResources::InitializeCairoProgram(ProgramBinaryCache& cache)
+{
+	if(!cache.Load(m_cairoProgram, {
+		{GL_VERTEX_SHADER, "shaders/cairo-vertex.glsl"},
+		{GL_FRAGMENT_SHADER, "shaders/cairo-fragment.glsl"}}))
+	{
+		LogError("failed to load cairo shaders, aborting");
+		exit(1);
+	}
+}
+
+void SharedGLResources::LoadEyeColorRamps()
+{
+	char tmp[1024];
+	const char* fnames[OscilloscopeWindow::NUM_EYE_COLORS];
+	fnames[OscilloscopeWindow::EYE_CRT] = "gradients/eye-gradient-crt.rgba";
+	fnames[OscilloscopeWindow::EYE_IRONBOW] = "gradients/eye-gradient-ironbow.rgba";
+	fnames[OscilloscopeWindow::EYE_KRAIN] = "gradients/eye-gradient-krain.rgba";
+	fnames[OscilloscopeWindow::EYE_RAINBOW] = "gradients/eye-gradient-rainbow.rgba";
+	fnames[OscilloscopeWindow::EYE_GRAYSCALE] = "gradients/eye-gradient-grayscale.rgba";
+	fnames[OscilloscopeWindow::EYE_VIRIDIS] = "gradients/eye-gradient-viridis.rgba";
+	for(int i=0; i<OscilloscopeWindow::NUM_EYE_COLORS; i++)
+	{
+		FILE* fp = fopen(fnames[i], "r");
+		if(!fp)
+			LogFatal("fail to open eye gradient");
+		fread(tmp, 1, 1024, fp);
+		fclose(fp);
+
+		//No texture filtering
+		m_eyeColorRamp[i].Bind();
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		m_eyeColorRamp[i].SetData(256, 1, tmp, GL_RGBA);
+	}
+}
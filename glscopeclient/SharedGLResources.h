@@ -0,0 +1,80 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of SharedGLResources
+ */
+#ifndef SharedGLResources_h
+#define SharedGLResources_h
+
+/**
+	@brief Shader programs and color ramps used by every WaveformArea.
+
+	GTK creates every GLArea context in a window sharing objects with the window's paint context, so one copy of
+	each program and texture serves all of them. Instances are refcounted and looked up by that shared context;
+	only the first view to be realized pays for loading shaders (see ProgramBinaryCache) and gradients from disk.
+
+	Container objects (VAOs, FBOs) can't be shared between contexts and stay in WaveformArea.
+ */
+class SharedGLResources
+{
+public:
+	static SharedGLResources* Acquire(Glib::RefPtr<Gdk::GLContext> context);
+	void Release();
+
+	Program m_waveformComputeProgram;
+	Program m_waveformTransformProgram;
+	Program m_waveformIndexProgram;
+	Program m_colormapProgram;
+	Program m_eyeProgram;
+	Program m_cairoProgram;
+	Texture m_eyeColorRamp[6];
+
+protected:
+	SharedGLResources(GdkGLContext* key);
+	virtual ~SharedGLResources();
+
+	void InitializeWaveformPrograms(ProgramBinaryCache& cache);
+	void InitializeColormapProgram(ProgramBinaryCache& cache);
+	void InitializeEyeProgram(ProgramBinaryCache& cache);
+	void InitializeCairoProgram(ProgramBinaryCache& cache);
+	void LoadEyeColorRamps();
+
+	///@brief The context we're shared through
+	GdkGLContext* m_key;
+
+	///@brief Number of WaveformAreas using us
+	int m_refcount;
+
+	static std::map<GdkGLContext*, SharedGLResources*> m_instances;
+};
+
+#endif
@@ -0,0 +1,198 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of SpillWriter
+ */
+#include "glscopeclient.h"
+#include "SpillWriter.h"
+
+using namespace std;
+
+//Number of channels waiting to be written past which the disk isn't keeping up, and holding on to more would just
+//move the backlog from the UI to memory
+#define SPILL_MAX_PENDING	256
+
+//Samples per fwrite()
+#define SPILL_CHUNK_SAMPLES	4096
+
+SpillWriter::SpillWriter(const string& dir)
+	: m_dir(dir)
+	, m_stopping(false)
+	, m_thread(&SpillWriter::WriterThread, this)
+{
+}
+
+/**
+	@brief Stops the writer thread once everything that was queued has been written
+ */
+SpillWriter::~SpillWriter()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_cond.notify_one();
+	m_thread.join();
+}
+
+/**
+	@brief Takes the waveform a scope's channels currently hold and queues it to be written out.
+
+	The channels are detached, and the writer thread owns (and will free) the data. Never refuses, it's up to the
+	caller to stop producing waveforms while IsBacklogged().
+ */
+void SpillWriter::Write(Oscilloscope* scope)
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+
+		//One file per channel, named after the instrument, capture timestamp and channel
+		for(size_t i=0; i<scope->GetChannelCount(); i++)
+		{
+			auto chan = scope->GetChannel(i);
+			auto data = chan->GetData();
+			if(!dynamic_cast<AnalogCapture*>(data) && !dynamic_cast<DigitalCapture*>(data))
+				continue;
+
+			char fname[1024];
+			snprintf(fname, sizeof(fname), "%s/%s_%ld_%012ld_%s.bin",
+				m_dir.c_str(),
+				scope->m_nickname.c_str(),
+				(long)data->m_startTimestamp,
+				(long)data->m_startPicoseconds,
+				chan->GetHwname().c_str());
+
+			SpillJob job;
+			job.m_fname = fname;
+			job.m_data = data;
+			m_jobs.push_back(job);
+			chan->Detach();
+		}
+	}
+	m_cond.notify_one();
+}
+
+/**
+	@brief Checks if the disk has fallen behind. Safe to call from any thread.
+ */
+bool SpillWriter::IsBacklogged()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return (m_jobs.size() >= SPILL_MAX_PENDING);
+}
+
+void SpillWriter::WriterThread()
+{
+	#ifndef _WIN32
+	pthread_setname_np(pthread_self(), "SpillWriter");
+	#endif
+
+	while(true)
+	{
+		SpillJob job;
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_cond.wait(lock, [this]{ return !m_jobs.empty() || m_stopping; });
+			if(m_jobs.empty())
+				return;
+			job = m_jobs.front();
+			m_jobs.pop_front();
+		}
+
+		WriteFile(job.m_fname, job.m_data);
+		delete job.m_data;
+	}
+}
+
+/**
+	@brief Appends an integer to a buffer, little-endian
+ */
+static void PutLE(vector<uint8_t>& buf, uint64_t value, size_t bytes)
+{
+	for(size_t i=0; i<bytes; i++)
+		buf.push_back( (value >> (i*8)) & 0xff );
+}
+
+/**
+	@brief Writes one channel's capture as a SpillFileHeader followed by the samples (see SpillFileHeader for the
+	exact layout)
+ */
+void SpillWriter::WriteFile(const string& fname, CaptureChannelBase* data)
+{
+	auto adat = dynamic_cast<AnalogCapture*>(data);
+	auto ddat = dynamic_cast<DigitalCapture*>(data);
+	size_t depth = data->GetDepth();
+
+	vector<uint8_t> buf;
+	buf.insert(buf.end(), "GSCSPILL", "GSCSPILL" + 8);
+	PutLE(buf, SPILL_FILE_VERSION, 4);
+	PutLE(buf, adat ? SPILL_ANALOG : SPILL_DIGITAL, 4);
+	PutLE(buf, depth, 8);
+	PutLE(buf, data->m_timescale, 8);
+	PutLE(buf, data->m_triggerPhase, 8);
+	PutLE(buf, data->m_startTimestamp, 8);
+	PutLE(buf, data->m_startPicoseconds, 8);
+
+	FILE* fp = fopen(fname.c_str(), "wb");
+	if(!fp)
+	{
+		LogError("Couldn't open spill file %s\n", fname.c_str());
+		return;
+	}
+
+	bool ok = (buf.size() == fwrite(&buf[0], 1, buf.size(), fp));
+	for(size_t base=0; ok && (base < depth); base += SPILL_CHUNK_SAMPLES)
+	{
+		buf.clear();
+		size_t end = min(depth, base + SPILL_CHUNK_SAMPLES);
+		for(size_t i=base; i<end; i++)
+		{
+			PutLE(buf, data->GetSampleStart(i), 8);
+			PutLE(buf, data->GetSampleLen(i), 8);
+			if(adat)
+			{
+				uint32_t bits;
+				float value = adat->m_samples[i].m_sample;
+				memcpy(&bits, &value, sizeof(bits));
+				PutLE(buf, bits, 4);
+			}
+			else
+				PutLE(buf, ddat->m_samples[i].m_sample ? 1 : 0, 1);
+		}
+		ok = (buf.size() == fwrite(&buf[0], 1, buf.size(), fp));
+	}
+	if(0 != fclose(fp))
+		ok = false;
+
+	if(!ok)
+		LogError("Couldn't write spill file %s\n", fname.c_str());
+}
@@ -0,0 +1,114 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of SpillWriter
+ */
+#ifndef SpillWriter_h
+#define SpillWriter_h
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/**
+	@brief Header at the start of each spill file
+
+	Every field is written little-endian, in this order, with no padding (56 bytes total). It's followed by m_depth
+	samples, each written as:
+		int64_t	offset in timescale units
+		int64_t	duration in timescale units
+		float	value (SPILL_ANALOG, 20 bytes per sample), or
+		uint8_t	value, 0 or 1 (SPILL_DIGITAL, 17 bytes per sample)
+	also little-endian with no padding.
+ */
+struct SpillFileHeader
+{
+	char		m_magic[8];				//"GSCSPILL"
+	uint32_t	m_version;				//SPILL_FILE_VERSION
+	uint32_t	m_type;					//SPILL_ANALOG or SPILL_DIGITAL
+	uint64_t	m_depth;				//Number of samples
+	int64_t		m_timescale;			//Picoseconds per offset/duration unit
+	int64_t		m_triggerPhase;			//Picoseconds from the trigger to offset zero
+	int64_t		m_startTimestamp;		//Capture time, seconds since the epoch
+	int64_t		m_startPicoseconds;		//Capture time, fractional part
+};
+
+#define SPILL_FILE_VERSION	2
+
+enum SpillSampleType
+{
+	SPILL_ANALOG	= 0,
+	SPILL_DIGITAL	= 1
+};
+
+/**
+	@brief Writes waveforms to disk on a background thread, for the spill backpressure policy
+
+	The UI thread hands over the capture objects themselves, so nothing is copied and the only work done on the UI
+	thread is detaching them from their channels. The writer thread saves each one in a simple binary format
+	(see SpillFileHeader) and then frees it.
+
+	Nothing handed over is ever thrown away. When the disk can't keep up, IsBacklogged() tells the acquisition thread
+	to stop triggering until it catches up.
+ */
+class SpillWriter
+{
+public:
+	SpillWriter(const std::string& dir);
+	~SpillWriter();
+
+	void Write(Oscilloscope* scope);
+	bool IsBacklogged();
+
+protected:
+	void WriterThread();
+	void WriteFile(const std::string& fname, CaptureChannelBase* data);
+
+	std::string m_dir;
+
+	///@brief One channel of a waveform waiting to be written
+	struct SpillJob
+	{
+		std::string m_fname;
+		CaptureChannelBase* m_data;
+	};
+
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+	std::deque<SpillJob> m_jobs;
+	bool m_stopping;
+
+	std::thread m_thread;
+};
+
+#endif
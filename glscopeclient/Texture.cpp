@@ -35,9 +35,10 @@
 #include "glscopeclient.h"
 #include "Texture.h"
 
-Texture::Texture()
+Texture::Texture(GLenum target)
 {
 	m_handle = 0;
+	m_target = target;
 }
 
 Texture::~Texture()
@@ -41,7 +41,7 @@
 class Texture
 {
 public:
-	Texture();
+	Texture(GLenum target = GL_TEXTURE_2D);
 	virtual ~Texture();
 
 	operator GLuint()
@@ -56,12 +56,15 @@ public:
 		}
 	}
 
-	void Bind(GLenum target = GL_TEXTURE_2D)
+	void Bind()
 	{
 		LazyInit();
-		glBindTexture(target, m_handle);
+		glBindTexture(m_target, m_handle);
 	}
 
+	GLenum GetTarget()
+	{ return m_target; }
+
 	//we must be bound to use these functions
 	void SetData(
 		size_t width,
@@ -77,6 +80,35 @@ public:
 		glTexImage2D(target, mipmap, internalformat, width, height, 0, format, type, data);
 	}
 
+	void SetSubData(
+		size_t x,
+		size_t y,
+		size_t width,
+		size_t height,
+		const void* data,
+		GLenum format = GL_RGBA,
+		GLenum type = GL_UNSIGNED_BYTE,
+		GLenum target = GL_TEXTURE_2D,
+		int mipmap = 0
+		)
+	{
+		glTexSubImage2D(target, mipmap, x, y, width, height, format, type, data);
+	}
+
+	void SetArrayData(
+		size_t width,
+		size_t height,
+		size_t layers,
+		void* data = NULL,
+		GLenum format = GL_RGBA,
+		GLenum type = GL_UNSIGNED_BYTE,
+		GLint internalformat = GL_RGBA8,
+		int mipmap = 0
+		)
+	{
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, mipmap, internalformat, width, height, layers, 0, format, type, data);
+	}
+
 protected:
 
 	/**
@@ -89,6 +121,9 @@ protected:
 	}
 
 	GLuint	m_handle;
+
+	///@brief Target the texture is bound to (GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, etc)
+	GLenum	m_target;
 };
 
 #endif
@@ -0,0 +1,131 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of TexturePool
+ */
+#include "glscopeclient.h"
+#include "TexturePool.h"
+
+using namespace std;
+
+TexturePool::TexturePool()
+	: m_allocations(0)
+{
+}
+
+TexturePool::~TexturePool()
+{
+	Clear();
+}
+
+/**
+	@brief Gets a texture array of the requested size and format, reusing a released one if possible.
+
+	Contents of the texture are undefined. The texture is left bound to GL_TEXTURE_2D_ARRAY.
+ */
+Texture* TexturePool::Acquire(size_t width, size_t height, size_t layers, GLint internalformat)
+{
+	Format format(width, height, layers, internalformat);
+
+	auto& pool = m_free[format];
+	if(!pool.empty())
+	{
+		auto tex = pool.back();
+		pool.pop_back();
+		tex->Bind();
+		return tex;
+	}
+
+	//Nothing suitable, make a new one.
+	//Render targets are never filtered, so turn that off up front.
+	auto tex = new Texture(GL_TEXTURE_2D_ARRAY);
+	tex->Bind();
+	tex->SetArrayData(width, height, layers, NULL, GL_RED, GL_FLOAT, internalformat);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	m_textures[tex] = format;
+	m_allocations ++;
+	return tex;
+}
+
+/**
+	@brief Returns a texture to the pool so it can be handed out again
+ */
+void TexturePool::Release(Texture* tex)
+{
+	if(tex == NULL)
+		return;
+
+	auto it = m_textures.find(tex);
+	if(it == m_textures.end())
+	{
+		LogError("TexturePool: released a texture we don't own\n");
+		return;
+	}
+	m_free[it->second].push_back(tex);
+}
+
+/**
+	@brief Frees all released textures that aren't the given size (they won't be needed again after a resize)
+ */
+void TexturePool::Trim(size_t width, size_t height)
+{
+	for(auto it = m_free.begin(); it != m_free.end(); )
+	{
+		if( (it->first.m_width == width) && (it->first.m_height == height) )
+		{
+			it++;
+			continue;
+		}
+
+		for(auto tex : it->second)
+		{
+			m_textures.erase(tex);
+			delete tex;
+		}
+		it = m_free.erase(it);
+	}
+}
+
+/**
+	@brief Frees every texture, including ones still in use. Must be called with the owning GL context current.
+ */
+void TexturePool::Clear()
+{
+	for(auto it : m_textures)
+		delete it.first;
+	m_textures.clear();
+	m_free.clear();
+}
@@ -0,0 +1,98 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of TexturePool
+ */
+#ifndef TexturePool_h
+#define TexturePool_h
+
+/**
+	@brief Hands out render target texture arrays and recycles them when they're released.
+
+	Textures are only reallocated when no free texture of the requested size and format exists, so resizing to the
+	same size or removing one overlay and adding another doesn't touch GPU memory at all.
+
+	All textures belong to the GL context that was current when they were acquired.
+ */
+class TexturePool
+{
+public:
+	TexturePool();
+	virtual ~TexturePool();
+
+	Texture* Acquire(size_t width, size_t height, size_t layers, GLint internalformat);
+	void Release(Texture* tex);
+	void Trim(size_t width, size_t height);
+	void Clear();
+
+	///@brief Number of textures actually allocated on the GPU so far
+	size_t GetAllocationCount()
+	{ return m_allocations; }
+
+protected:
+	class Format
+	{
+	public:
+		Format(size_t width = 0, size_t height = 0, size_t layers = 0, GLint internalformat = 0)
+		: m_width(width)
+		, m_height(height)
+		, m_layers(layers)
+		, m_internalformat(internalformat)
+		{}
+
+		bool operator<(const Format& rhs) const
+		{
+			if(m_width != rhs.m_width)
+				return m_width < rhs.m_width;
+			if(m_height != rhs.m_height)
+				return m_height < rhs.m_height;
+			if(m_layers != rhs.m_layers)
+				return m_layers < rhs.m_layers;
+			return m_internalformat < rhs.m_internalformat;
+		}
+
+		size_t	m_width;
+		size_t	m_height;
+		size_t	m_layers;
+		GLint	m_internalformat;
+	};
+
+	///@brief Format of every texture we own, in use or not
+	std::map<Texture*, Format> m_textures;
+
+	///@brief Textures not currently in use, by format
+	std::map<Format, std::vector<Texture*> > m_free;
+
+	size_t m_allocations;
+};
+
+#endif
@@ -0,0 +1,198 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of ThreadPool
+ */
+#include "glscopeclient.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+//The pool the current thread belongs to (if any), and its index in that pool
+static thread_local ThreadPool* g_currentPool = NULL;
+static thread_local size_t g_currentWorker = 0;
+
+ThreadPool::ThreadPool(size_t nthreads)
+	: m_nextQueue(0)
+	, m_pending(0)
+	, m_idle(0)
+	, m_stopping(false)
+{
+	if(nthreads < 1)
+		nthreads = 1;
+
+	for(size_t i=0; i<nthreads; i++)
+		m_queues.push_back(new WorkerQueue);
+	for(size_t i=0; i<nthreads; i++)
+		m_threads.push_back(new thread(&ThreadPool::WorkerThread, this, i));
+}
+
+/**
+	@brief Stops the workers once they've finished everything that's been submitted
+ */
+ThreadPool::~ThreadPool()
+{
+	{
+		lock_guard<mutex> lock(m_idleMutex);
+		m_stopping = true;
+	}
+	m_idleCond.notify_all();
+
+	for(auto t : m_threads)
+	{
+		t->join();
+		delete t;
+	}
+	for(auto q : m_queues)
+		delete q;
+}
+
+/**
+	@brief Queues a task to run on one of the workers. Safe to call from any thread, including from a task.
+ */
+void ThreadPool::Submit(function<void()> task)
+{
+	size_t index;
+	if(g_currentPool == this)
+		index = g_currentWorker;
+	else
+		index = m_nextQueue.fetch_add(1) % m_queues.size();
+
+	{
+		lock_guard<mutex> lock(m_queues[index]->m_mutex);
+		m_queues[index]->m_tasks.push_back(task);
+	}
+
+	//Only wake someone up if anyone is asleep. A worker counts itself idle before it checks m_pending for the
+	//last time, so either it sees this task or we see it's idle.
+	m_pending ++;
+	if(m_idle > 0)
+	{
+		lock_guard<mutex> lock(m_idleMutex);
+		m_idleCond.notify_one();
+	}
+}
+
+/**
+	@brief Claims one of the pending tasks for the calling worker, if there are any
+
+	@return True if there's now a task in some queue reserved for us
+ */
+bool ThreadPool::ClaimTask()
+{
+	size_t pending = m_pending;
+	while(pending > 0)
+	{
+		if(m_pending.compare_exchange_weak(pending, pending - 1))
+			return true;
+	}
+	return false;
+}
+
+/**
+	@brief Gets the next task for a worker: the newest of its own, or failing that the oldest of someone else's
+
+	@return False if there's no work anywhere
+ */
+bool ThreadPool::PopTask(size_t index, function<void()>& task)
+{
+	{
+		auto q = m_queues[index];
+		lock_guard<mutex> lock(q->m_mutex);
+		if(!q->m_tasks.empty())
+		{
+			task = q->m_tasks.back();
+			q->m_tasks.pop_back();
+			return true;
+		}
+	}
+
+	for(size_t i=1; i<m_queues.size(); i++)
+	{
+		auto q = m_queues[(index + i) % m_queues.size()];
+		lock_guard<mutex> lock(q->m_mutex);
+		if(!q->m_tasks.empty())
+		{
+			task = q->m_tasks.front();
+			q->m_tasks.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ThreadPool::WorkerThread(size_t index)
+{
+	#ifndef _WIN32
+	pthread_setname_np(pthread_self(), "PoolWorker");
+	#endif
+
+	g_currentPool = this;
+	g_currentWorker = index;
+
+	while(true)
+	{
+		//Wait until there's work (or we're shutting down and there's none left)
+		if(!ClaimTask())
+		{
+			unique_lock<mutex> lock(m_idleMutex);
+			m_idle ++;
+			m_idleCond.wait(lock, [this]{ return (m_pending > 0) || m_stopping; });
+			m_idle --;
+			if(!ClaimTask())
+			{
+				if(m_stopping)
+					return;
+				continue;
+			}
+		}
+
+		//We've claimed one task, so there's at least one in some queue for us
+		function<void()> task;
+		while(!PopTask(index, task))
+		{}
+
+		try
+		{
+			task();
+		}
+		catch(const exception& e)
+		{
+			LogError("Unhandled exception in thread pool task: %s\n", e.what());
+		}
+		catch(...)
+		{
+			LogError("Unhandled exception in thread pool task\n");
+		}
+	}
+}
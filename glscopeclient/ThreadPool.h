@@ -0,0 +1,96 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Declaration of ThreadPool
+ */
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+	@brief Work-stealing pool of worker threads
+
+	Each worker has its own deque of tasks. Tasks submitted from a worker go on the back of its own deque and it
+	runs them newest first, so a task that unblocks another usually hands it straight to the same (cache-warm)
+	thread. Idle workers steal the oldest task from the front of another worker's deque. Tasks submitted from
+	outside the pool are spread round-robin.
+
+	Tasks are responsible for reporting their own errors back to whoever is waiting on them (see DecoderScheduler).
+	An exception that escapes a task anyway is logged and dropped, so it can't take the worker down with it.
+ */
+class ThreadPool
+{
+public:
+	ThreadPool(size_t nthreads);
+	~ThreadPool();
+
+	void Submit(std::function<void()> task);
+
+	size_t GetThreadCount()
+	{ return m_threads.size(); }
+
+protected:
+	void WorkerThread(size_t index);
+	bool ClaimTask();
+	bool PopTask(size_t index, std::function<void()>& task);
+
+	///@brief A single worker's tasks
+	class WorkerQueue
+	{
+	public:
+		std::mutex m_mutex;
+		std::deque< std::function<void()> > m_tasks;
+	};
+
+	std::vector<WorkerQueue*> m_queues;
+	std::vector<std::thread*> m_threads;
+
+	///@brief Next queue to put a task submitted from outside the pool in
+	std::atomic<size_t> m_nextQueue;
+
+	///@brief Number of tasks submitted and not yet claimed by a worker
+	std::atomic<size_t> m_pending;
+
+	//Sleeping when there's no work. Submit() only takes the mutex if someone is asleep.
+	std::mutex m_idleMutex;
+	std::condition_variable m_idleCond;
+	std::atomic<size_t> m_idle;
+	bool m_stopping;
+};
+
+#endif
@@ -42,6 +42,8 @@
 using namespace std;
 using namespace glm;
 
+extern bool g_gpuGeometry;
+
 WaveformArea::WaveformArea(
 	Oscilloscope* scope,
 	OscilloscopeChannel* channel,
@@ -83,6 +85,9 @@ void WaveformArea::SharedCtorInit()
 	m_texDownloadTime		= 0;
 	m_compositeTime			= 0;
 	m_indexTime 			= 0;
+	m_geometryBytes			= 0;
+	m_geometrySamples		= 0;
+	m_heapAllocations		= 0;
 	m_lastFrameStart 		= -1;
 
 	m_updatingContextMenu 	= false;
@@ -92,6 +97,24 @@ void WaveformArea::SharedCtorInit()
 	m_persistenceClear 		= true;
 	m_firstFrame 			= false;
 	m_waveformRenderData	= NULL;
+	m_digitalOverlayRenderData	= NULL;
+	m_shared				= NULL;
+	m_eyeTextureWidth		= 0;
+	m_eyeTextureHeight		= 0;
+	m_waterfallHead			= 0;
+	m_waterfallNewLines		= 0;
+
+	m_dirty					= DIRTY_ALL;
+	m_lastPixelsPerXUnit	= 0;
+	m_lastXAxisOffset		= 0;
+	m_lastPixelsPerVolt		= 0;
+	m_lastOffset			= 0;
+	m_lastPlotRight			= 0;
+	m_lastTraceAlpha		= 0;
+	m_alphaScale			= 1;
+
+	m_underlayCacheHits		= 0;
+	m_underlayCacheMisses	= 0;
 
 	set_has_alpha();
 
@@ -126,6 +149,9 @@ WaveformArea::~WaveformArea()
 			m_renderTime * 1000, m_renderTime * 1000 / m_frameCount, 100.0f);
 		LogDebug("Cairo             | %10.1f |   %10.3f | %.1f %%\n",
 			m_cairoTime * 1000, m_cairoTime * 1000 / m_frameCount, m_cairoTime * 100 / m_renderTime);
+		LogDebug("Underlay cache    | %10ld hits, %ld misses\n",
+			m_underlayCacheHits, m_underlayCacheMisses);
+		LogDebug("Texture allocs    | %10zu |\n", m_texturePool.GetAllocationCount());
 		LogDebug("Texture download  | %10.1f |   %10.3f | %.1f %%\n",
 			m_texDownloadTime * 1000, m_texDownloadTime * 1000 / m_frameCount, m_texDownloadTime * 100 / m_renderTime);
 		LogDebug("Prepare           | %10.1f |   %10.3f | %.1f %%\n",
@@ -136,6 +162,16 @@ WaveformArea::~WaveformArea()
 			m_downloadTime * 1000, m_downloadTime * 1000 / m_frameCount, m_downloadTime * 100 / m_renderTime);
 		LogDebug("Composite         | %10.1f |   %10.3f | %.1f %%\n",
 			m_compositeTime * 1000, m_compositeTime * 1000 / m_frameCount, m_compositeTime * 100 / m_renderTime);
+		if(m_geometrySamples)
+		{
+			LogDebug("Geometry upload   | %10.2f bytes per sample (%s)\n",
+				m_geometryBytes * 1.0 / m_geometrySamples, g_gpuGeometry ? "GPU" : "CPU");
+		}
+#ifdef COUNT_HEAP_ALLOCATIONS
+		LogDebug("----------------------------------------------------------\n");
+		LogDebug("Heap allocations  | %10lu |   %10.1f |\n",
+			m_heapAllocations, m_heapAllocations * 1.0 / m_frameCount);
+#endif
 	}
 
 	m_channel->Release();
@@ -161,11 +197,54 @@ void WaveformArea::OnRemoveOverlay(ProtocolDecoder* decode)
 	//Remove the render data for it
 	auto it = m_overlayRenderData.find(decode);
 	if(it != m_overlayRenderData.end())
+	{
+		delete it->second;
 		m_overlayRenderData.erase(it);
+	}
+	auto rit = m_overlayRenderers.find(decode);
+	if(rit != m_overlayRenderers.end())
+	{
+		delete rit->second;
+		m_overlayRenderers.erase(rit);
+	}
+
+	SetDirty(DIRTY_OVERLAYS);
 
 	decode->Release();
 }
 
+/**
+	@brief Called when a channel's name or other settings shown in the info boxes were changed from a dialog
+
+	If this view shows the channel, either as the main trace or an overlay, redraw the label layers.
+ */
+void WaveformArea::OnChannelPropertiesChanged(OscilloscopeChannel* chan)
+{
+	bool shown = (chan == m_channel);
+	for(auto o : m_overlays)
+	{
+		if(o == chan)
+			shown = true;
+	}
+	if(!shown)
+		return;
+
+	SetDirty(DIRTY_OVERLAYS);
+	queue_draw();
+}
+
+/**
+	@brief Called after a set of protocol decoders was refreshed
+
+	Every refresh of a waterfall adds one line at the top and scrolls the rest of the image down, so counting them
+	tells UpdateWaterfallTexture() how many lines are new.
+ */
+void WaveformArea::OnDecodersRefreshed(const set<ProtocolDecoder*>& decoders)
+{
+	if(IsWaterfall() && (decoders.find(dynamic_cast<ProtocolDecoder*>(m_channel)) != decoders.end()) )
+		m_waterfallNewLines ++;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Initialization
 
@@ -446,15 +525,19 @@ void WaveformArea::on_realize()
 	//This means we need to save some configuration (like the current FBO) that GTK doesn't tell us directly
 	m_firstFrame = true;
 
-	//Create waveform render data for our main trace
+	double start = GetTime();
+
+	//Create waveform render data for our main trace, and for the overlays (which get filled in later)
 	m_waveformRenderData = new WaveformRenderData(m_channel);
+	m_digitalOverlayRenderData = new WaveformRenderData(NULL);
 
 	//Set stuff up for each rendering pass
-	InitializeWaveformPass();
+	m_shared = SharedGLResources::Acquire(get_context());
 	InitializeColormapPass();
-	InitializePersistencePass();
 	InitializeCairoPass();
 	InitializeEyePass();
+
+	LogDebug("Realized view for %s in %.3f ms\n", m_channel->m_displayname.c_str(), (GetTime() - start) * 1000);
 }
 
 void WaveformArea::on_unrealize()
@@ -468,80 +551,49 @@ void WaveformArea::on_unrealize()
 
 void WaveformArea::CleanupGLHandles()
 {
-	//Clean up old shaders
-	m_waveformComputeProgram.Destroy();
-	m_colormapProgram.Destroy();
-	m_persistProgram.Destroy();
-	m_eyeProgram.Destroy();
-	m_cairoProgram.Destroy();
+	//Drop our reference to the shared shaders (freed once the last view in the window is gone)
+	if(m_shared)
+		m_shared->Release();
+	m_shared = NULL;
 
 	//Clean up old VAOs
 	m_colormapVAO.Destroy();
-	m_persistVAO.Destroy();
 	m_cairoVAO.Destroy();
 	m_eyeVAO.Destroy();
 
 	//Clean up old VBOs
 	m_colormapVBO.Destroy();
-	m_persistVBO.Destroy();
 	m_cairoVBO.Destroy();
 	m_eyeVBO.Destroy();
 
 	//Clean up old textures
 	m_cairoTexture.Destroy();
-	m_cairoTextureOver.Destroy();
-	for(auto& e : m_eyeColorRamp)
-		e.Destroy();
+	m_underlayKey = UnderlayKey();
+	m_cairoTextureDecodes.Destroy();
+	m_cairoTextureInfoBox.Destroy();
+	m_cairoTextureCursors.Destroy();
+	m_eyeTexture.Destroy();
+	m_eyePixelBuffer.Destroy();
+	m_eyeTextureWidth = 0;
+	m_eyeTextureHeight = 0;
+	m_waterfallNewLines = 0;
 
 	delete m_waveformRenderData;
 	m_waveformRenderData = NULL;
+	delete m_digitalOverlayRenderData;
+	m_digitalOverlayRenderData = NULL;
 	for(auto it : m_overlayRenderData)
 		delete it.second;
 	m_overlayRenderData.clear();
+	m_texturePool.Clear();
 
 	//Detach the FBO so we don't destroy it!!
 	//GTK manages this, and it might be used by more than one waveform area within the application.
 	m_windowFramebuffer.Detach();
 }
 
-void WaveformArea::InitializeWaveformPass()
-{
-	//ProfileBlock pb("Load waveform shaders");
-	ComputeShader wc;
-	if(!wc.Load("shaders/waveform-compute.glsl"))
-	{
-		LogError("failed to load waveform compute shader, aborting");
-		exit(1);
-	}
-	m_waveformComputeProgram.Add(wc);
-	if(!m_waveformComputeProgram.Link())
-	{
-		LogError("failed to link shader program, aborting");
-		exit(1);
-	}
-}
-
 void WaveformArea::InitializeColormapPass()
 {
-	//ProfileBlock pb("Load colormap shaders");
-
-	//Set up shaders
-	VertexShader cvs;
-	FragmentShader cfs;
-	if(!cvs.Load("shaders/colormap-vertex.glsl") || !cfs.Load("shaders/colormap-fragment.glsl"))
-	{
-		LogError("failed to load colormap shaders, aborting");
-		exit(1);
-	}
-
-	m_colormapProgram.Add(cvs);
-	m_colormapProgram.Add(cfs);
-	if(!m_colormapProgram.Link())
-	{
-		LogError("failed to link shader program, aborting");
-		exit(1);
-	}
-
 	//Create the VAO/VBO for a fullscreen polygon
 	float verts[8] =
 	{
@@ -554,29 +606,12 @@ void WaveformArea::InitializeColormapPass()
 	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
 
 	m_colormapVAO.Bind();
-	m_colormapProgram.EnableVertexArray("vert");
-	m_colormapProgram.SetVertexAttribPointer("vert", 2, 0);
+	m_shared->m_colormapProgram.EnableVertexArray("vert");
+	m_shared->m_colormapProgram.SetVertexAttribPointer("vert", 2, 0);
 }
 
 void WaveformArea::InitializeEyePass()
 {
-	//Set up shaders
-	VertexShader cvs;
-	FragmentShader cfs;
-	if(!cvs.Load("shaders/eye-vertex.glsl") || !cfs.Load("shaders/eye-fragment.glsl"))
-	{
-		LogError("failed to load eye shaders, aborting");
-		exit(1);
-	}
-
-	m_eyeProgram.Add(cvs);
-	m_eyeProgram.Add(cfs);
-	if(!m_eyeProgram.Link())
-	{
-		LogError("failed to link shader program, aborting");
-		exit(1);
-	}
-
 	//Create the VAO/VBO for a fullscreen polygon
 	float verts[8] =
 	{
@@ -589,88 +624,12 @@ void WaveformArea::InitializeEyePass()
 	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
 
 	m_eyeVAO.Bind();
-	m_eyeProgram.EnableVertexArray("vert");
-	m_eyeProgram.SetVertexAttribPointer("vert", 2, 0);
-
-	//Load the eye color ramp
-	char tmp[1024];
-	const char* fnames[OscilloscopeWindow::NUM_EYE_COLORS];
-	fnames[OscilloscopeWindow::EYE_CRT] = "gradients/eye-gradient-crt.rgba";
-	fnames[OscilloscopeWindow::EYE_IRONBOW] = "gradients/eye-gradient-ironbow.rgba";
-	fnames[OscilloscopeWindow::EYE_KRAIN] = "gradients/eye-gradient-krain.rgba";
-	fnames[OscilloscopeWindow::EYE_RAINBOW] = "gradients/eye-gradient-rainbow.rgba";
-	fnames[OscilloscopeWindow::EYE_GRAYSCALE] = "gradients/eye-gradient-grayscale.rgba";
-	fnames[OscilloscopeWindow::EYE_VIRIDIS] = "gradients/eye-gradient-viridis.rgba";
-	for(int i=0; i<OscilloscopeWindow::NUM_EYE_COLORS; i++)
-	{
-		FILE* fp = fopen(fnames[i], "r");
-		if(!fp)
-			LogFatal("fail to open eye gradient");
-		fread(tmp, 1, 1024, fp);
-		fclose(fp);
-
-		m_eyeColorRamp[i].Bind();
-		ResetTextureFiltering();
-		m_eyeColorRamp[i].SetData(256, 1, tmp, GL_RGBA);
-	}
-}
-
-void WaveformArea::InitializePersistencePass()
-{
-	//ProfileBlock pb("Load persistence shaders");
-
-	//Set up shaders
-	VertexShader cvs;
-	FragmentShader cfs;
-	if(!cvs.Load("shaders/persist-vertex.glsl") || !cfs.Load("shaders/persist-fragment.glsl"))
-	{
-		LogError("failed to load persist shaders, aborting");
-		exit(1);
-	}
-
-	m_persistProgram.Add(cvs);
-	m_persistProgram.Add(cfs);
-	if(!m_persistProgram.Link())
-	{
-		LogError("failed to link shader program, aborting");
-		exit(1);
-	}
-
-	//Create the VAO/VBO for a fullscreen polygon
-	float verts[8] =
-	{
-		-1, -1,
-		 1, -1,
-		 1,  1,
-		-1,  1
-	};
-	m_persistVBO.Bind();
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
-
-	m_persistVAO.Bind();
-	m_persistProgram.EnableVertexArray("vert");
-	m_persistProgram.SetVertexAttribPointer("vert", 2, 0);
+	m_shared->m_eyeProgram.EnableVertexArray("vert");
+	m_shared->m_eyeProgram.SetVertexAttribPointer("vert", 2, 0);
 }
 
 void WaveformArea::InitializeCairoPass()
 {
-	//Set up shaders
-	VertexShader cvs;
-	FragmentShader cfs;
-	if(!cvs.Load("shaders/cairo-vertex.glsl") || !cfs.Load("shaders/cairo-fragment.glsl"))
-	{
-		LogError("failed to load cairo shaders, aborting");
-		exit(1);
-	}
-
-	m_cairoProgram.Add(cvs);
-	m_cairoProgram.Add(cfs);
-	if(!m_cairoProgram.Link())
-	{
-		LogError("failed to link shader program, aborting");
-		exit(1);
-	}
-
 	//Create the VAO/VBO for a fullscreen polygon
 	float verts[8] =
 	{
@@ -683,8 +642,8 @@ void WaveformArea::InitializeCairoPass()
 	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
 
 	m_cairoVAO.Bind();
-	m_cairoProgram.EnableVertexArray("vert");
-	m_cairoProgram.SetVertexAttribPointer("vert", 2, 0);
+	m_shared->m_cairoProgram.EnableVertexArray("vert");
+	m_shared->m_cairoProgram.SetVertexAttribPointer("vert", 2, 0);
 }
 
 bool WaveformArea::IsWaterfall()
@@ -36,6 +36,10 @@
 #define WaveformArea_h
 
 #include "WaveformGroup.h"
+#include "MinMaxPyramid.h"
+#include "WaveformTransform.h"
+#include "WaveformRenderConfig.h"
+#include "SharedGLResources.h"
 
 /**
 	@brief Slightly more capable rectangle class
@@ -86,21 +90,97 @@ public:
 	WaveformRenderData(OscilloscopeChannel* channel)
 	: m_channel(channel)
 	, m_geometryOK(false)
-	{}
+	, m_waveformTexture(NULL)
+	, m_textureLayers(0)
+	{
+		if(channel)
+			m_layers.push_back(channel);
+	}
 
-	//The channel of interest
+	//The channel of interest (NULL if this holds several channels' worth of layers)
 	OscilloscopeChannel*	m_channel;
 
+	//The channel drawn in each layer of m_waveformTexture
+	std::vector<OscilloscopeChannel*>	m_layers;
+
 	//True if everything is good to render
 	bool					m_geometryOK;
 
-	//SSBOs with waveform data
+	//SSBOs with waveform data (persistently mapped rings, written directly by PrepareGeometry)
 	ShaderStorageBuffer		m_waveformStorageBuffer;
 	ShaderStorageBuffer		m_waveformConfigBuffer;
 	ShaderStorageBuffer		m_waveformIndexBuffer;
+	ShaderStorageBuffer		m_waveformDescriptorBuffer;
+
+	//SSBOs with raw sample data (only used when geometry is computed on the GPU)
+	ShaderStorageBuffer		m_waveformSampleBuffer;
+	ShaderStorageBuffer		m_waveformTimestampBuffer;
+	ShaderStorageBuffer		m_waveformTransformConfigBuffer;
 
-	//RGBA32 but only alpha actually used
-	Texture					m_waveformTexture;
+	//Single channel intensity buffer with one layer per channel, borrowed from the parent WaveformArea's texture pool
+	Texture*				m_waveformTexture;
+	size_t					m_textureLayers;
+
+	//CPU-side copy of the X coordinates in m_waveformStorageBuffer, for building the index
+	std::vector<float>		m_xCoords;
+
+	//Waveforms waiting to be accumulated into the persistence buffer on the next frame
+	std::vector<float>				m_batchGeometry;
+	std::vector<uint32_t>			m_batchIndex;
+	std::vector<WaveformDescriptor>	m_batchDescriptors;
+
+	//Decimated copy of the capture for wide zooms (analog only, built on demand)
+	MinMaxPyramid			m_pyramid;
+};
+
+/**
+	@brief Everything the Cairo underlay (background gradient, grid, and trigger arrow) depends on.
+
+	If none of these change, the previously rendered underlay texture is reused as-is.
+ */
+class UnderlayKey
+{
+public:
+	UnderlayKey()
+	: m_width(0)
+	, m_height(0)
+	, m_voltageRange(0)
+	, m_offset(0)
+	, m_fft(false)
+	, m_trigger(false)
+	, m_triggerVoltage(0)
+	, m_dragging(false)
+	, m_cursorY(0)
+	{}
+
+	bool operator==(const UnderlayKey& rhs) const
+	{
+		return
+			(m_width == rhs.m_width) &&
+			(m_height == rhs.m_height) &&
+			(m_voltageRange == rhs.m_voltageRange) &&
+			(m_offset == rhs.m_offset) &&
+			(m_color == rhs.m_color) &&
+			(m_fft == rhs.m_fft) &&
+			(m_trigger == rhs.m_trigger) &&
+			(m_triggerVoltage == rhs.m_triggerVoltage) &&
+			(m_dragging == rhs.m_dragging) &&
+			(m_cursorY == rhs.m_cursorY);
+	}
+
+	bool operator!=(const UnderlayKey& rhs) const
+	{ return !(*this == rhs); }
+
+	int			m_width;
+	int			m_height;
+	float		m_voltageRange;
+	float		m_offset;
+	std::string	m_color;
+	bool		m_fft;
+	bool		m_trigger;
+	float		m_triggerVoltage;
+	bool		m_dragging;
+	float		m_cursorY;
 };
 
 float sinc(float x, float width);
@@ -116,6 +196,8 @@ public:
 	virtual ~WaveformArea();
 
 	void OnWaveformDataReady();
+	void OnChannelPropertiesChanged(OscilloscopeChannel* chan);
+	void OnDecodersRefreshed(const std::set<ProtocolDecoder*>& decoders);
 
 	OscilloscopeChannel* GetChannel()
 	{ return m_channel; }
@@ -123,9 +205,26 @@ public:
 	void ClearPersistence()
 	{ m_persistenceClear = true; }
 
-	//TODO: dirtiness needs complete revamp
-	void SetGeometryDirty()
-	{  }
+	bool IsPersistenceEnabled()
+	{ return m_persistence; }
+
+	/**
+		@brief Things that may have changed since the last frame, used by on_render() to decide what to redo
+	 */
+	enum DirtyFlags
+	{
+		DIRTY_DATA		= 0x01,		//New waveform data for the main channel or an overlay
+		DIRTY_X			= 0x02,		//Horizontal scale, offset, or plot width
+		DIRTY_Y			= 0x04,		//Vertical scale, offset, or plot height
+		DIRTY_OVERLAYS	= 0x08,		//Protocol decode overlays added, removed, or reconfigured, or channel names changed
+		DIRTY_CURSORS	= 0x10,		//Cursors moved or changed mode
+		DIRTY_ALPHA		= 0x20,		//Trace alpha changed, existing waveform textures need rescaling
+
+		DIRTY_ALL		= 0x3f
+	};
+
+	void SetDirty(unsigned int flags)
+	{ m_dirty |= flags; }
 
 	WaveformGroup* m_group;
 
@@ -251,13 +350,61 @@ protected:
 
 	Framebuffer m_windowFramebuffer;
 
+	//Dirty tracking
+	void UpdateDirtyFlags();
+	unsigned int m_dirty;
+	float m_lastPixelsPerXUnit;
+	int64_t m_lastXAxisOffset;
+	float m_lastPixelsPerVolt;
+	float m_lastOffset;
+	float m_lastPlotRight;
+	float m_lastTraceAlpha;
+	float m_alphaScale;
+
+	//Programs and color ramps, shared with every other WaveformArea in our window
+	SharedGLResources* m_shared;
+
 	//Trace rendering
 	void RenderTrace(WaveformRenderData* wdata);
-	void InitializeWaveformPass();
+	void RescaleTrace(WaveformRenderData* wdata);
 	void PrepareGeometry(WaveformRenderData* wdata);
-	Program m_waveformComputeProgram;
+	bool GetGeometryParameters(
+		WaveformRenderData* wdata,
+		size_t& count,
+		size_t& level,
+		double& xscale,
+		float& xoff,
+		float& ybase);
+	void GenerateGeometry(
+		WaveformRenderData* wdata,
+		size_t count,
+		size_t level,
+		double xscale,
+		float xoff,
+		float ybase,
+		float* traceBuffer,
+		uint32_t* indexBuffer);
+	void GetTransformConfig(
+		WaveformRenderData* wdata,
+		size_t count,
+		double xscale,
+		float xoff,
+		float ybase,
+		WaveformTransformConfig& config);
+	void WriteRenderConfig(WaveformRenderData* wdata, uint32_t numWaveforms, float persistDecay);
+	void UploadBatch(WaveformRenderData* wdata);
+	void PrepareOverlayGeometry();
+	void PrepareGeometryOnGPU(
+		WaveformRenderData* wdata,
+		size_t count,
+		size_t level,
+		double xscale,
+		float xoff,
+		float ybase);
 	WaveformRenderData*								m_waveformRenderData;
-	std::map<ProtocolDecoder*, WaveformRenderData*>	m_overlayRenderData;
+	std::map<ProtocolDecoder*, WaveformRenderData*>	m_overlayRenderData;		//CPU-side scratch data only
+	WaveformRenderData*								m_digitalOverlayRenderData;	//All digital overlays, a layer each
+	TexturePool										m_texturePool;
 
 	//Final compositing
 	void RenderMainTrace();
@@ -268,57 +415,96 @@ protected:
 	void InitializeColormapPass();
 	VertexArray m_colormapVAO;
 	VertexBuffer m_colormapVBO;
-	Program m_colormapProgram;
 
 	//Persistence
-	void RenderPersistenceOverlay();
-	void InitializePersistencePass();
-	Program m_persistProgram;
-	VertexArray m_persistVAO;
-	VertexBuffer m_persistVBO;
+	void StagePersistenceWaveform();
+	void PreparePersistenceBatch(WaveformRenderData* wdata);
 
 	//Eye pattern rendering
 	void RenderEye();
+	void UpdateEyeTexture();
 	void InitializeEyePass();
-	Program m_eyeProgram;
+	bool ResizeEyeTexture(size_t width, size_t height);
 	VertexArray m_eyeVAO;
 	VertexBuffer m_eyeVBO;
 	Texture m_eyeTexture;
-	Texture m_eyeColorRamp[6];
+	PixelBuffer m_eyePixelBuffer;
+	size_t m_eyeTextureWidth;
+	size_t m_eyeTextureHeight;
 
-	//Waterfall rendering
+	//Waterfall rendering.
+	//m_eyeTexture is used as a ring of rows, so each new FFT only uploads one row.
 	void RenderWaterfall();
+	void UpdateWaterfallTexture();
+	size_t m_waterfallHead;			//Row of the ring holding the newest line
+	size_t m_waterfallNewLines;		//Number of times the decoder ran (adding a line each time) since the last upload
 
 	//Cairo overlay rendering for text and protocol decode overlays
 	void ComputeAndDownloadCairoUnderlays();
 	void ComputeAndDownloadCairoOverlays();
+	void ComputeAndDownloadCairoLayer(
+		Texture& tex,
+		void (WaveformArea::*render)(Cairo::RefPtr< Cairo::Context > cr));
 	void RenderCairoUnderlays();
 	void DoRenderCairoUnderlays(Cairo::RefPtr< Cairo::Context > cr);
 	void RenderBackgroundGradient(Cairo::RefPtr< Cairo::Context > cr);
 	void RenderGrid(Cairo::RefPtr< Cairo::Context > cr);
 	void RenderCairoOverlays();
-	void DoRenderCairoOverlays(Cairo::RefPtr< Cairo::Context > cr);
+	void RenderCairoLayer(Texture& tex);
 	void RenderCursors(Cairo::RefPtr< Cairo::Context > cr);
 	void RenderChannelLabel(Cairo::RefPtr< Cairo::Context > cr);
 	void RenderDecodeOverlays(Cairo::RefPtr< Cairo::Context > cr);
+	void RenderTextOverlay(
+		Cairo::RefPtr< Cairo::Context > cr,
+		TextRenderer* render,
+		CaptureChannelBase* data,
+		int textright,
+		double ybot,
+		double ymid,
+		double ytop);
+	void RenderDensityBar(
+		Cairo::RefPtr< Cairo::Context > cr,
+		double xs,
+		double xe,
+		double ytop,
+		double ybot,
+		const Gdk::Color& color,
+		int textright);
+	int64_t XPositionToCaptureUnits(CaptureChannelBase* data, float pix);
+	static size_t BinarySearchForSampleStart(CaptureChannelBase* data, int64_t t, size_t low, size_t high);
 	void InitializeCairoPass();
+	Cairo::RefPtr< Cairo::Context > GetCairoScratchContext();
+	Cairo::RefPtr< Cairo::ImageSurface > m_cairoSurface;
+	Cairo::RefPtr< Cairo::Context > m_cairoContext;
+	Glib::RefPtr<Pango::Layout> m_gridLayout;
+	Glib::RefPtr<Pango::Layout> m_infoBoxLayout;
+	std::string m_infoBoxLayoutText;
+	std::string m_channelLabel;
+	std::map<ProtocolDecoder*, ChannelRenderer*> m_overlayRenderers;
 	Texture m_cairoTexture;
-	Texture m_cairoTextureOver;
+	UnderlayKey m_underlayKey;
+	long m_underlayCacheHits;
+	long m_underlayCacheMisses;
+	Texture m_cairoTextureDecodes;
+	Texture m_cairoTextureInfoBox;
+	Texture m_cairoTextureCursors;
 	VertexArray m_cairoVAO;
 	VertexBuffer m_cairoVBO;
-	Program m_cairoProgram;
 
 	//Helpers for rendering and such
 	void RenderChannelInfoBox(
 		OscilloscopeChannel* chan,
 		Cairo::RefPtr< Cairo::Context > cr,
 		int bottom,
-		std::string text,
+		const std::string& text,
 		Rect& box,
 		int labelmargin = 6);
 
 	void ResetTextureFiltering();
 
+	const Gdk::Color& GetColor(const std::string& name);
+	std::map<std::string, Gdk::Color> m_colorCache;
+
 	//Math helpers
 	float PixelsToVolts(float pix);
 	float VoltsToPixels(float volt);
@@ -352,6 +538,12 @@ protected:
 	double m_indexTime;
 	double m_downloadTime;
 
+	//Bytes written to the GPU for the main waveform's geometry, and how many samples that was for
+	uint64_t m_geometryBytes;
+	uint64_t m_geometrySamples;
+
+	uint64_t m_heapAllocations;
+
 	float m_pixelsPerVolt;
 	float m_padding;
 	float m_plotRight;
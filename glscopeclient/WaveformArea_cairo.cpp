@@ -64,7 +64,7 @@ void WaveformArea::RenderBackgroundGradient(Cairo::RefPtr< Cairo::Context > cr)
 	float top_brightness = 0.1;
 	float bottom_brightness = 0.0;
 
-	Gdk::Color color(m_channel->m_displaycolor);
+	auto& color = GetColor(m_channel->m_displaycolor);
 
 	Cairo::RefPtr<Cairo::LinearGradient> background_gradient = Cairo::LinearGradient::create(0, ytop, 0, ybot);
 	background_gradient->add_color_stop_rgb(
@@ -87,10 +87,14 @@ void WaveformArea::RenderGrid(Cairo::RefPtr< Cairo::Context > cr)
 	//Calculate width of right side axis label
 	int twidth;
 	int theight;
-	Glib::RefPtr<Pango::Layout> tlayout = Pango::Layout::create (cr);
-	Pango::FontDescription font("monospace normal 10");
-	font.set_weight(Pango::WEIGHT_NORMAL);
-	tlayout->set_font_description(font);
+	if(!m_gridLayout)
+	{
+		m_gridLayout = Pango::Layout::create (cr);
+		Pango::FontDescription font("monospace normal 10");
+		font.set_weight(Pango::WEIGHT_NORMAL);
+		m_gridLayout->set_font_description(font);
+	}
+	auto& tlayout = m_gridLayout;
 	tlayout->set_text("500 mV_xxx");
 	tlayout->get_pixel_size(twidth, theight);
 	m_plotRight = m_width - twidth;
@@ -100,7 +104,7 @@ void WaveformArea::RenderGrid(Cairo::RefPtr< Cairo::Context > cr)
 
 	cr->save();
 
-	Gdk::Color color(m_channel->m_displaycolor);
+	auto& color = GetColor(m_channel->m_displaycolor);
 
 	float ytop = m_height - m_padding;
 	float ybot = m_padding;
@@ -231,13 +235,6 @@ void WaveformArea::RenderGrid(Cairo::RefPtr< Cairo::Context > cr)
 	cr->restore();
 }
 
-void WaveformArea::DoRenderCairoOverlays(Cairo::RefPtr< Cairo::Context > cr)
-{
-	RenderDecodeOverlays(cr);
-	RenderChannelLabel(cr);
-	RenderCursors(cr);
-}
-
 void WaveformArea::RenderDecodeOverlays(Cairo::RefPtr< Cairo::Context > cr)
 {
 	//TODO: adjust height/spacing depending on font sizes etc
@@ -278,7 +275,11 @@ void WaveformArea::RenderDecodeOverlays(Cairo::RefPtr< Cairo::Context > cr)
 
 	for(auto o : m_overlays)
 	{
-		auto render = o->CreateRenderer();
+		//Renderers are stateless, so keep them around rather than making a new one every time
+		auto rit = m_overlayRenderers.find(o);
+		if(rit == m_overlayRenderers.end())
+			rit = m_overlayRenderers.emplace(o, o->CreateRenderer()).first;
+		auto render = rit->second;
 		auto data = o->GetData();
 
 		bool digital = dynamic_cast<DigitalRenderer*>(render) != NULL;
@@ -310,40 +311,161 @@ void WaveformArea::RenderDecodeOverlays(Cairo::RefPtr< Cairo::Context > cr)
 		//Handle text
 		auto tr = dynamic_cast<TextRenderer*>(render);
 		if(tr != NULL)
-		{
-			for(size_t i=0; i<data->GetDepth(); i++)
-			{
-				double start = (data->GetSampleStart(i) * data->m_timescale) + data->m_triggerPhase;
-				double end = start + (data->GetSampleLen(i) * data->m_timescale);
+			RenderTextOverlay(cr, tr, data, textright, ybot, ymid, ytop);
+	}
+}
+
+/**
+	@brief Draws the symbols of a text protocol decode that are within the visible part of the plot.
+
+	Symbols are sorted by start time, so we binary search for the first visible one and stop after the last rather
+	than looking at the entire capture. Wherever more than one symbol starts within the same pixel, they're drawn as
+	a solid density bar instead of individually.
+ */
+void WaveformArea::RenderTextOverlay(
+	Cairo::RefPtr< Cairo::Context > cr,
+	TextRenderer* render,
+	CaptureChannelBase* data,
+	int textright,
+	double ybot,
+	double ymid,
+	double ytop)
+{
+	size_t depth = data->GetDepth();
+	if(depth == 0)
+		return;
+
+	//Start at the last symbol starting left of the plot, since it may extend into it
+	size_t i = BinarySearchForSampleStart(data, XPositionToCaptureUnits(data, textright), 0, depth);
+	if(i > 0)
+		i--;
 
-				double xs = XAxisUnitsToXPosition(start);
-				double xe = XAxisUnitsToXPosition(end);
+	//Density bar being built up (not drawn yet)
+	bool inBar = false;
+	double barStart = 0;
+	double barEnd = 0;
+	Gdk::Color barColor;
+
+	for(; i<depth; i++)
+	{
+		double start = (data->GetSampleStart(i) * data->m_timescale) + data->m_triggerPhase;
+		double end = start + (data->GetSampleLen(i) * data->m_timescale);
 
-				if( (xe < textright) || (xs > m_plotRight) )
-					continue;
+		double xs = XAxisUnitsToXPosition(start);
+		double xe = XAxisUnitsToXPosition(end);
 
-				auto text = tr->GetText(i);
-				auto color = tr->GetColor(i);
+		if(xs > m_plotRight)
+			break;
+		if(xe < textright)
+			continue;
+
+		//If the symbol is less than a pixel wide, see how many more start in the same pixel.
+		//More than one, skip all of them and add them to the density bar.
+		size_t next = i + 1;
+		if(xe - xs < 1)
+			next = BinarySearchForSampleStart(data, XPositionToCaptureUnits(data, xs + 1), i + 1, depth);
+		if(next > i + 1)
+		{
+			double last = (data->GetSampleStart(next-1) + data->GetSampleLen(next-1)) * data->m_timescale;
+			xe = XAxisUnitsToXPosition(last + data->m_triggerPhase);
 
-				render->RenderComplexSignal(
-					cr,
-					textright, m_plotRight,
-					xs, xe, 5,
-					ybot, ymid, ytop,
-					text,
-					color);
+			//Merge with the current bar if it's touching, otherwise draw the old one and start over
+			if(inBar && (xs <= barEnd + 1) )
+				barEnd = max(barEnd, xe);
+			else
+			{
+				if(inBar)
+					RenderDensityBar(cr, barStart, barEnd, ytop, ybot, barColor, textright);
+				inBar = true;
+				barStart = xs;
+				barEnd = xe;
+				barColor = render->GetColor(i);
 			}
+
+			i = next - 1;
+			continue;
+		}
+
+		//Normal symbol, finish any bar to the left of it first
+		if(inBar)
+		{
+			RenderDensityBar(cr, barStart, barEnd, ytop, ybot, barColor, textright);
+			inBar = false;
 		}
 
-		delete render;
+		render->RenderComplexSignal(
+			cr,
+			textright, m_plotRight,
+			xs, xe, 5,
+			ybot, ymid, ytop,
+			render->GetText(i),
+			render->GetColor(i));
 	}
+
+	if(inBar)
+		RenderDensityBar(cr, barStart, barEnd, ytop, ybot, barColor, textright);
+}
+
+/**
+	@brief Draws a solid bar representing many symbols too small to draw individually
+ */
+void WaveformArea::RenderDensityBar(
+	Cairo::RefPtr< Cairo::Context > cr,
+	double xs,
+	double xe,
+	double ytop,
+	double ybot,
+	const Gdk::Color& color,
+	int textright)
+{
+	xs = max(xs, (double)textright);
+	xe = min(xe, (double)m_plotRight);
+	if(xe <= xs)
+		return;
+
+	cr->set_source_rgb(color.get_red_p(), color.get_green_p(), color.get_blue_p());
+	cr->rectangle(xs, ytop, max(xe - xs, 1.0), ybot - ytop);
+	cr->fill();
+}
+
+/**
+	@brief Converts an X position to a timestamp in a capture's own units (as returned by GetSampleStart)
+ */
+int64_t WaveformArea::XPositionToCaptureUnits(CaptureChannelBase* data, float pix)
+{
+	return (XPositionToXAxisUnits(pix) - data->m_triggerPhase) / data->m_timescale;
+}
+
+/**
+	@brief Find the first sample in [low, high) that starts at or after a given time
+
+	@param data		The capture to search. Samples must be sorted by start time.
+	@param t		Time to search for, in the capture's own units
+	@param low		First sample to consider
+	@param high		One past the last sample to consider
+
+	@return Index of the sample, or high if there are none
+ */
+size_t WaveformArea::BinarySearchForSampleStart(CaptureChannelBase* data, int64_t t, size_t low, size_t high)
+{
+	while(low < high)
+	{
+		size_t mid = low + (high - low)/2;
+		if(data->GetSampleStart(mid) < t)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
 }
 
 void WaveformArea::RenderChannelLabel(Cairo::RefPtr< Cairo::Context > cr)
 {
 	//Add sample rate info to physical channels
 	//TODO: do this to some decodes too?
-	string label = m_channel->m_displayname;
+	//Built in a member so it reuses the same buffer every frame
+	auto& label = m_channelLabel;
+	label = m_channel->m_displayname;
 	auto data = m_channel->GetData();
 	if(m_channel->IsPhysicalChannel() && (data != NULL) )
 	{
@@ -380,18 +502,27 @@ void WaveformArea::RenderChannelInfoBox(
 		OscilloscopeChannel* chan,
 		Cairo::RefPtr< Cairo::Context > cr,
 		int bottom,
-		string text,
+		const string& text,
 		Rect& box,
 		int labelmargin)
 {
 	//Figure out text size
 	int twidth;
 	int theight;
-	Glib::RefPtr<Pango::Layout> tlayout = Pango::Layout::create (cr);
-	Pango::FontDescription font("sans normal 10");
-	font.set_weight(Pango::WEIGHT_NORMAL);
-	tlayout->set_font_description(font);
-	tlayout->set_text(text);
+	if(!m_infoBoxLayout)
+	{
+		m_infoBoxLayout = Pango::Layout::create (cr);
+		Pango::FontDescription font("sans normal 10");
+		font.set_weight(Pango::WEIGHT_NORMAL);
+		m_infoBoxLayout->set_font_description(font);
+	}
+	auto& tlayout = m_infoBoxLayout;
+	if(text != m_infoBoxLayoutText)
+	{
+		//Only when it changes, set_text() copies it to a Glib::ustring and then into Pango
+		tlayout->set_text(text);
+		m_infoBoxLayoutText = text;
+	}
 	tlayout->get_pixel_size(twidth, theight);
 
 	//Channel-colored rounded outline
@@ -423,7 +554,7 @@ void WaveformArea::RenderChannelInfoBox(
 		cr->fill_preserve();
 
 		//Draw the outline
-		Gdk::Color color(chan->m_displaycolor);
+		auto& color = GetColor(chan->m_displaycolor);
 		cr->set_source_rgba(color.get_red_p(), color.get_green_p(), color.get_blue_p(), 1);
 		cr->set_line_width(1);
 		cr->stroke();
@@ -444,8 +575,8 @@ void WaveformArea::RenderCursors(Cairo::RefPtr< Cairo::Context > cr)
 	int ytop = m_height;
 	int ybot = 0;
 
-	Gdk::Color yellow("yellow");
-	Gdk::Color orange("orange");
+	auto& yellow = GetColor("yellow");
+	auto& orange = GetColor("orange");
 
 	if( (m_group->m_cursorConfig == WaveformGroup::CURSOR_X_DUAL) ||
 		(m_group->m_cursorConfig == WaveformGroup::CURSOR_X_SINGLE) )
@@ -70,20 +70,15 @@ void WaveformArea::on_resize(int width, int height)
 	if(err != 0)
 		LogNotice("resize 2, err = %x\n", err);
 
-	//Reallocate waveform texture
-	m_waveformRenderData->m_waveformTexture.Bind();
-	m_waveformRenderData->m_waveformTexture.SetData(width, height, NULL, GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA32F);
-	ResetTextureFiltering();
+	//Waveform textures get swapped for ones of the new size next time they're rendered.
+	//If the size didn't actually change, we get the same textures back.
+	m_texturePool.Release(m_waveformRenderData->m_waveformTexture);
+	m_texturePool.Release(m_digitalOverlayRenderData->m_waveformTexture);
+	m_waveformRenderData->m_waveformTexture = NULL;
+	m_digitalOverlayRenderData->m_waveformTexture = NULL;
+	m_texturePool.Trim(width, height);
 
-	//Reallocate textures for overlays
-	for(auto it : m_overlayRenderData)
-	{
-		it.second->m_waveformTexture.Bind();
-		it.second->m_waveformTexture.SetData(width, height, NULL, GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA32F);
-		ResetTextureFiltering();
-	}
-
-	SetGeometryDirty();
+	SetDirty(DIRTY_ALL);
 
 	err = glGetError();
 	if(err != 0)
@@ -146,12 +141,12 @@ bool WaveformArea::on_scroll_event (GdkEventScroll* ev)
 				{
 					case GDK_SCROLL_UP:
 						m_channel->SetVoltageRange(vrange * 0.9);
-						SetGeometryDirty();
+						SetDirty(DIRTY_Y);
 						queue_draw();
 						break;
 					case GDK_SCROLL_DOWN:
 						m_channel->SetVoltageRange(vrange / 0.9);
-						SetGeometryDirty();
+						SetDirty(DIRTY_Y);
 						queue_draw();
 						break;
 
@@ -222,7 +217,7 @@ void WaveformArea::OnSingleClick(GdkEventButton* event, int64_t timestamp)
 
 						//Redraw if we have any cursor
 						if(m_group->m_cursorConfig != WaveformGroup::CURSOR_NONE)
-							m_group->m_vbox.queue_draw();
+							m_group->OnCursorMoved();
 
 						break;
 
@@ -298,7 +293,7 @@ void WaveformArea::OnDoubleClick(GdkEventButton* /*event*/, int64_t /*timestamp*
 					if(dialog.run() == Gtk::RESPONSE_OK)
 					{
 						dialog.ConfigureChannel();
-						queue_draw();
+						m_parent->OnChannelPropertiesChanged(m_selectedChannel);
 					}
 				}
 
@@ -309,6 +304,8 @@ void WaveformArea::OnDoubleClick(GdkEventButton* /*event*/, int64_t /*timestamp*
 					if(dialog.run() == Gtk::RESPONSE_OK)
 					{
 						dialog.ConfigureDecoder();
+						SetDirty(DIRTY_ALL);
+						m_parent->OnChannelPropertiesChanged(m_selectedChannel);
 						queue_draw();
 					}
 				}
@@ -339,7 +336,10 @@ bool WaveformArea::on_button_release_event(GdkEventButton* event)
 
 		case DRAG_CURSOR:
 			if(m_group->m_cursorConfig == WaveformGroup::CURSOR_X_DUAL)
+			{
 				m_group->m_xCursorPos[1] = timestamp;
+				m_group->OnCursorMoved();
+			}
 			break;
 
 		default:
@@ -376,7 +376,7 @@ bool WaveformArea::on_motion_notify_event(GdkEventMotion* event)
 			if(m_group->m_cursorConfig == WaveformGroup::CURSOR_X_DUAL)
 			{
 				m_group->m_xCursorPos[1] = timestamp;
-				m_group->m_vbox.queue_draw();
+				m_group->OnCursorMoved();
 			}
 			break;
 
@@ -397,7 +397,7 @@ void WaveformArea::OnCursorConfig(WaveformGroup::CursorConfig config, Gtk::Radio
 		return;
 
 	m_group->m_cursorConfig = config;
-	m_group->m_vbox.queue_draw();
+	m_group->OnCursorMoved();
 }
 
 void WaveformArea::OnMoveNewRight()
@@ -452,6 +452,7 @@ void WaveformArea::OnHide()
 			}
 		}
 
+		SetDirty(DIRTY_OVERLAYS);
 		queue_draw();
 	}
 }
@@ -459,6 +460,7 @@ void WaveformArea::OnHide()
 void WaveformArea::OnTogglePersistence()
 {
 	m_persistence = !m_persistence;
+	ClearPersistence();
 	queue_draw();
 }
 
@@ -516,6 +518,7 @@ void WaveformArea::OnProtocolDecode(string name)
 		decode->AddRef();
 		m_overlays.push_back(decode);
 		m_parent->AddDecoder(decode);
+		SetDirty(DIRTY_OVERLAYS);
 		queue_draw();
 	}
 
@@ -574,8 +577,18 @@ void WaveformArea::OnWaveformDataReady()
 		m_group->m_xAxisOffset = -eye->GetUIWidth();
 	}
 
+	//Old decimated data is no longer useful
+	if(m_waveformRenderData)
+		m_waveformRenderData->m_pyramid.Clear();
+	for(auto it : m_overlayRenderData)
+		it.second->m_pyramid.Clear();
+
+	//With persistence on, every waveform has to end up on screen even if we don't render a frame for it
+	if(m_persistence)
+		StagePersistenceWaveform();
+
 	//Update our measurements and redraw the waveform
-	SetGeometryDirty();
+	SetDirty(DIRTY_DATA);
 	queue_draw();
 	m_group->m_timeline.queue_draw();
 }
@@ -36,6 +36,8 @@
 #include "glscopeclient.h"
 #include "WaveformArea.h"
 #include "OscilloscopeWindow.h"
+#include "ColumnIndex.h"
+#include "WaveformTransform.h"
 #include <random>
 #include <map>
 #include "ProfileBlock.h"
@@ -47,64 +49,119 @@
 using namespace std;
 using namespace glm;
 
+extern bool g_gpuGeometry;
+
+//Number of layers composited per draw call (size of the colors array in colormap-fragment.glsl)
+#define MAX_COMPOSITE_LAYERS		16
+
+//Decay applied to the persistence buffer for each new waveform
+#define PERSIST_DECAY				0.9f
+
+//Limits on how many waveforms can be staged for persistence between two frames
+#define PERSIST_MAX_BATCH			64
+#define PERSIST_MAX_BATCH_POINTS	(16 * 1024 * 1024)
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Rendering
 
-void WaveformArea::PrepareGeometry(WaveformRenderData* wdata)
-{
-	double start = GetTime();
+/**
+	@brief Figures out how a waveform's samples map to pixel coordinates.
 
+	@return False if there's nothing to draw
+ */
+bool WaveformArea::GetGeometryParameters(
+	WaveformRenderData* wdata,
+	size_t& count,
+	size_t& level,
+	double& xscale,
+	float& xoff,
+	float& ybase)
+{
 	auto channel = wdata->m_channel;
 	auto pdat = channel->GetData();
 	auto andat = dynamic_cast<AnalogCapture*>(pdat);
 	auto digdat = dynamic_cast<DigitalCapture*>(pdat);
 	if( !(andat && andat->GetDepth()) && !(digdat && digdat->GetDepth()))
-	{
-		wdata->m_geometryOK = false;
-		return;
-	}
+		return false;
 
-	size_t count;
 	if(andat)
 		count = andat->size();
 	else
 		count = digdat->size();
-	double xscale = pdat->m_timescale * m_group->m_pixelsPerXUnit;
-	float xoff = (pdat->m_triggerPhase - m_group->m_xAxisOffset) * m_group->m_pixelsPerXUnit;
-
-	bool fft = IsFFT();
+	xscale = pdat->m_timescale * m_group->m_pixelsPerXUnit;
+	xoff = (pdat->m_triggerPhase - m_group->m_xAxisOffset) * m_group->m_pixelsPerXUnit;
 
 	//Zero voltage level
 	//TODO: don't assume all digital data is a protocol decode, logic analyzers are a thing!
 	//TODO: properly calculate decoder positions once RenderDecodeOverlays() isn't doing that anymore
-	float ybase = m_height/2;
+	ybase = m_height/2;
 	if(digdat)
 		ybase = m_height - (m_overlayPositions[dynamic_cast<ProtocolDecoder*>(channel)] + 15);
 
+	//If we're zoomed out far enough that there's many samples per pixel, draw from the min/max pyramid instead
+	level = 0;
+	if(andat && (count > 1))
+	{
+		level = wdata->m_pyramid.SelectLevel(andat, xscale, xoff, m_plotRight);
+		if(level > 0)
+			count = wdata->m_pyramid.GetPointCount(level);
+	}
+
+	return true;
+}
+
+/**
+	@brief Calculates pixel coordinates of each sample, and the column index, on the CPU
+
+	@param traceBuffer	Output buffer for interleaved X/Y coordinates (count*2 floats)
+	@param indexBuffer	Output buffer for the index of the first sample in each column (m_width entries)
+ */
+void WaveformArea::GenerateGeometry(
+	WaveformRenderData* wdata,
+	size_t count,
+	size_t level,
+	double xscale,
+	float xoff,
+	float ybase,
+	float* traceBuffer,
+	uint32_t* indexBuffer)
+{
+	double start = GetTime();
+
+	auto pdat = wdata->m_channel->GetData();
+	auto andat = dynamic_cast<AnalogCapture*>(pdat);
+	auto digdat = dynamic_cast<DigitalCapture*>(pdat);
+
+	WaveformTransformConfig config;
+	GetTransformConfig(wdata, count, xscale, xoff, ybase, config);
+
+	//The mapped memory is usually write-combined and slow to read back, so keep the X coordinates
+	//on the CPU side as well for building the index
+	auto& xcoords = wdata->m_xCoords;
+	xcoords.resize(count);
+
 	//Calculate X/Y coordinate of each sample point
-	//TODO: some of this can probably move to GPU too?
-	vector<float> traceBuffer;
-	vector<uint32_t> indexBuffer;
-	traceBuffer.resize(count*2);
-	indexBuffer.resize(m_width);
-	double offset = channel->GetOffset();
 	#pragma omp parallel for num_threads(8)
 	for(size_t j=0; j<count; j++)
 	{
-		traceBuffer[j*2] = pdat->GetSampleStart(j) * xscale + xoff;
-
-		float y;
-		if(digdat)
+		//Fetch the sample, either raw or from the pyramid
+		int64_t tstart;
+		float value;
+		if(level > 0)
+			wdata->m_pyramid.GetPoint(level, j, tstart, value);
+		else
 		{
-			//TODO: digital overlay stuff
-			y = ybase + 5 + ( (*digdat)[j] ? 20: 0 );
+			tstart = pdat->GetSampleStart(j);
+			if(digdat)
+				value = (*digdat)[j] ? 1 : 0;
+			else
+				value = (*andat)[j];
 		}
-		else if(fft)
-			y = DbToYPosition(-70 - (20 * log10((*andat)[j])));		//TODO: don't hard code plot limits
-		else
-			y = (m_pixelsPerVolt * ((*andat)[j] + offset)) + ybase;
 
-		traceBuffer[j*2 + 1]	= y;
+		float x = TransformX(config, tstart);
+		traceBuffer[j*2] = x;
+		xcoords[j] = x;
+		traceBuffer[j*2 + 1] = TransformY(config, value);
 	}
 
 	double dt = GetTime() - start;
@@ -114,52 +171,422 @@ void WaveformArea::PrepareGeometry(WaveformRenderData* wdata)
 	//Calculate indexes for rendering.
 	//This is necessary since samples may be sparse and have arbitrary spacing between them, so we can't
 	//trivially map sample indexes to X pixel coordinates.
-	//TODO: can we parallelize this? move to a compute shader?
-	size_t nsample = 0;
+	//X coordinates are monotonic, so each column can binary search for its first sample independently.
+	#pragma omp parallel for
 	for(int j=0; j<m_width; j++)
+		indexBuffer[j] = BinarySearchForGequal(&xcoords[0], count, j);
+
+	dt = GetTime() - start;
+	m_indexTime += dt;
+}
+
+void WaveformArea::PrepareGeometry(WaveformRenderData* wdata)
+{
+	size_t count;
+	size_t level;
+	double xscale;
+	float xoff;
+	float ybase;
+	if(!GetGeometryParameters(wdata, count, level, xscale, xoff, ybase))
+	{
+		wdata->m_geometryOK = false;
+		return;
+	}
+
+	//If we're doing the transform on the GPU, just hand off the raw samples
+	if(g_gpuGeometry)
+		PrepareGeometryOnGPU(wdata, count, level, xscale, xoff, ybase);
+	else
+	{
+		//Get space in the ring buffers to write the geometry and index to
+		double start = GetTime();
+		float* traceBuffer = reinterpret_cast<float*>(
+			wdata->m_waveformStorageBuffer.MapRingSegment(count*2*sizeof(float)));
+		uint32_t* indexBuffer = reinterpret_cast<uint32_t*>(
+			wdata->m_waveformIndexBuffer.MapRingSegment(m_width*sizeof(uint32_t)));
+		m_downloadTime += GetTime() - start;
+
+		GenerateGeometry(wdata, count, level, xscale, xoff, ybase, traceBuffer, indexBuffer);
+		m_geometryBytes += count*2*sizeof(float) + m_width*sizeof(uint32_t);
+	}
+	m_geometrySamples += count;
+	double start = GetTime();
+
+	//Single waveform, replacing whatever was drawn before
+	auto desc = reinterpret_cast<WaveformDescriptor*>(
+		wdata->m_waveformDescriptorBuffer.MapRingSegment(sizeof(WaveformDescriptor)));
+	desc->offset		= 0;
+	desc->depth			= count;
+	desc->indexOffset	= 0;
+	desc->weight		= m_parent->GetTraceAlpha() * 256;
+	desc->layer			= 0;
+	WriteRenderConfig(wdata, 1, 0);
+
+	m_downloadTime += GetTime() - start;
+
+	wdata->m_geometryOK = true;
+}
+
+/**
+	@brief Uploads the global configuration for waveform-compute.glsl
+
+	@param numWaveforms		Number of entries in the descriptor buffer
+	@param persistDecay		Factor to scale the previous contents of the waveform texture by (0 to overwrite)
+ */
+void WaveformArea::WriteRenderConfig(WaveformRenderData* wdata, uint32_t numWaveforms, float persistDecay)
+{
+	auto config = reinterpret_cast<WaveformRenderConfig*>(
+		wdata->m_waveformConfigBuffer.MapRingSegment(sizeof(WaveformRenderConfig)));
+	config->windowHeight	= m_height;
+	config->windowWidth		= m_plotRight;
+	config->numWaveforms	= numWaveforms;
+	config->persistDecay	= persistDecay;
+}
+
+/**
+	@brief Converts the current waveform to pixel coordinates and saves it to be drawn with persistence.
+
+	When waveforms arrive faster than we can render, several of them are staged between frames. The next frame
+	then accumulates all of them in one compute dispatch (see PreparePersistenceBatch()).
+ */
+void WaveformArea::StagePersistenceWaveform()
+{
+	auto wdata = m_waveformRenderData;
+	if( (wdata == NULL) || !IsAnalog() )
+		return;
+
+	size_t count;
+	size_t level;
+	double xscale;
+	float xoff;
+	float ybase;
+	if(!GetGeometryParameters(wdata, count, level, xscale, xoff, ybase))
+		return;
+
+	//If we've fallen so far behind that the batch is huge, start over.
+	//Anything in it would have decayed to nearly nothing by the end of the batch anyway.
+	auto& geom = wdata->m_batchGeometry;
+	auto& index = wdata->m_batchIndex;
+	auto& descs = wdata->m_batchDescriptors;
+	if( (descs.size() >= PERSIST_MAX_BATCH) || (geom.size() + count*2 > PERSIST_MAX_BATCH_POINTS*2) )
+	{
+		geom.clear();
+		index.clear();
+		descs.clear();
+	}
+
+	WaveformDescriptor desc;
+	desc.offset			= geom.size() / 2;
+	desc.depth			= count;
+	desc.indexOffset	= index.size();
+	desc.weight			= 0;
+	desc.layer			= 0;
+	descs.push_back(desc);
+
+	geom.resize(geom.size() + count*2);
+	index.resize(index.size() + m_width);
+	GenerateGeometry(wdata, count, level, xscale, xoff, ybase, &geom[desc.offset*2], &index[desc.indexOffset]);
+}
+
+/**
+	@brief Uploads all staged waveforms and sets up the descriptors to accumulate them on top of the existing
+	persistence buffer.
+
+	Older waveforms in the batch are weighted as if they had been drawn, and decayed, one at a time.
+ */
+void WaveformArea::PreparePersistenceBatch(WaveformRenderData* wdata)
+{
+	double start = GetTime();
+
+	auto& descs = wdata->m_batchDescriptors;
+	size_t n = descs.size();
+
+	float alpha = m_parent->GetTraceAlpha() * 256;
+	float weight = alpha;
+	for(size_t i=0; i<n; i++)
+	{
+		descs[n-1-i].weight = lround(weight);
+		weight *= PERSIST_DECAY;
+	}
+	UploadBatch(wdata);
+
+	//If persistence was just cleared, throw away whatever was there before
+	float decay = 0;
+	if(!m_persistenceClear)
+		decay = pow(PERSIST_DECAY, n);
+	WriteRenderConfig(wdata, n, decay);
+
+	m_downloadTime += GetTime() - start;
+
+	wdata->m_geometryOK = true;
+}
+
+/**
+	@brief Copies the batched geometry, index, and descriptors of a render data to the GPU, then empties the batch
+ */
+void WaveformArea::UploadBatch(WaveformRenderData* wdata)
+{
+	auto& geom = wdata->m_batchGeometry;
+	auto& index = wdata->m_batchIndex;
+	auto& descs = wdata->m_batchDescriptors;
+
+	memcpy(wdata->m_waveformStorageBuffer.MapRingSegment(geom.size()*sizeof(float)),
+		&geom[0], geom.size()*sizeof(float));
+	memcpy(wdata->m_waveformIndexBuffer.MapRingSegment(index.size()*sizeof(uint32_t)),
+		&index[0], index.size()*sizeof(uint32_t));
+	memcpy(wdata->m_waveformDescriptorBuffer.MapRingSegment(descs.size()*sizeof(WaveformDescriptor)),
+		&descs[0], descs.size()*sizeof(WaveformDescriptor));
+
+	geom.clear();
+	index.clear();
+	descs.clear();
+}
+
+/**
+	@brief Generates geometry for all digital overlays, so they can be rasterized in one pass with a layer each
+ */
+void WaveformArea::PrepareOverlayGeometry()
+{
+	auto batch = m_digitalOverlayRenderData;
+	auto& geom = batch->m_batchGeometry;
+	auto& index = batch->m_batchIndex;
+	auto& descs = batch->m_batchDescriptors;
+	batch->m_layers.clear();
+
+	uint32_t weight = m_parent->GetTraceAlpha() * 256;
+	for(auto overlay : m_overlays)
 	{
-		//Default to drawing nothing
-		indexBuffer[j] = count;
+		if(overlay->GetType() != OscilloscopeChannel::CHANNEL_TYPE_DIGITAL)
+			continue;
 
-		//Move forward until we find a sample that starts in the current column
-		for(; nsample < count-1; nsample ++)
+		//Create scratch space for the overlay if needed
+		//(can't do this when m_waveformRenderData is created because decoders are added later on)
+		WaveformRenderData* wdata;
+		auto it = m_overlayRenderData.find(overlay);
+		if(it != m_overlayRenderData.end())
+			wdata = it->second;
+		else
 		{
-			//If the next sample ends after the start of the current pixel. stop
-			float end = traceBuffer[(nsample+1)*2];
-			if(end >= j)
-			{
-				//Start the current column at this sample
-				indexBuffer[j] = nsample;
-				break;
-			}
+			wdata = new WaveformRenderData(overlay);
+			m_overlayRenderData[overlay] = wdata;
 		}
+
+		//Every overlay gets a layer even if there's nothing to draw, so it gets cleared
+		uint32_t layer = batch->m_layers.size();
+		batch->m_layers.push_back(overlay);
+
+		size_t count;
+		size_t level;
+		double xscale;
+		float xoff;
+		float ybase;
+		if(!GetGeometryParameters(wdata, count, level, xscale, xoff, ybase))
+			continue;
+
+		WaveformDescriptor desc;
+		desc.offset			= geom.size() / 2;
+		desc.depth			= count;
+		desc.indexOffset	= index.size();
+		desc.weight			= weight;
+		desc.layer			= layer;
+		descs.push_back(desc);
+
+		geom.resize(geom.size() + count*2);
+		index.resize(index.size() + m_width);
+		GenerateGeometry(wdata, count, level, xscale, xoff, ybase, &geom[desc.offset*2], &index[desc.indexOffset]);
 	}
 
-	dt = GetTime() - start;
-	m_indexTime += dt;
+	if(descs.empty())
+	{
+		batch->m_geometryOK = false;
+		return;
+	}
+
+	double start = GetTime();
+	size_t n = descs.size();
+	UploadBatch(batch);
+	WriteRenderConfig(batch, n, 0);
+	m_downloadTime += GetTime() - start;
+
+	batch->m_geometryOK = true;
+}
+
+/**
+	@brief Fills out the sample to pixel transform for a waveform
+ */
+void WaveformArea::GetTransformConfig(
+	WaveformRenderData* wdata,
+	size_t count,
+	double xscale,
+	float xoff,
+	float ybase,
+	WaveformTransformConfig& config)
+{
+	config.xscale			= xscale;
+	config.xoff				= xoff;
+	config.ybase			= ybase;
+	config.pixelsPerVolt	= m_pixelsPerVolt;
+	config.offset			= wdata->m_channel->GetOffset();
+	config.padding			= m_padding;
+	config.plotheight		= m_height - 2*m_padding;
+	config.memDepth			= count;
+	config.tstart			= 0;
+	config.tstep			= 0;
+	config.dense			= 0;
+	if(dynamic_cast<DigitalCapture*>(wdata->m_channel->GetData()))
+		config.mode			= TRANSFORM_DIGITAL;
+	else if(IsFFT())
+		config.mode			= TRANSFORM_FFT;
+	else
+		config.mode			= TRANSFORM_ANALOG;
+}
+
+/**
+	@brief Uploads the capture's sample values, then converts them to pixel coordinates and builds the column index
+	with compute shaders.
+
+	Only the values are uploaded (4 bytes per sample, vs 8 for the coordinates the CPU path uploads) if the samples
+	are uniformly spaced, and the shader generates the timestamps. Otherwise the 64-bit timestamps go up as well.
+
+	If level is nonzero, points come from that level of the min/max pyramid rather than the raw capture. There are
+	only a few per pixel, and they aren't uniformly spaced.
+ */
+void WaveformArea::PrepareGeometryOnGPU(
+	WaveformRenderData* wdata,
+	size_t count,
+	size_t level,
+	double xscale,
+	float xoff,
+	float ybase)
+{
+	double start = GetTime();
+
+	auto pdat = wdata->m_channel->GetData();
+	auto andat = dynamic_cast<AnalogCapture*>(pdat);
+	auto digdat = dynamic_cast<DigitalCapture*>(pdat);
+
+	auto& config = *reinterpret_cast<WaveformTransformConfig*>(
+		wdata->m_waveformTransformConfigBuffer.MapRingSegment(sizeof(WaveformTransformConfig)));
+	GetTransformConfig(wdata, count, xscale, xoff, ybase, config);
+
+	//Download the sample values, and see if we need the timestamps too
+	auto values = reinterpret_cast<float*>(wdata->m_waveformSampleBuffer.MapRingSegment(count*sizeof(float)));
+	if(level > 0)
+	{
+		auto offsets = reinterpret_cast<int64_t*>(
+			wdata->m_waveformTimestampBuffer.MapRingSegment(count*sizeof(int64_t)));
+		for(size_t j=0; j<count; j++)
+			wdata->m_pyramid.GetPoint(level, j, offsets[j], values[j]);
+	}
+	else
+	{
+		if(digdat)
+			PackSampleValues(digdat, count, values, config);
+		else
+			PackSampleValues(andat, count, values, config);
+
+		//Still have to bind something there even if the shader won't look at it
+		size_t offsetBytes = config.dense ? 0 : count*sizeof(int64_t);
+		auto offsets = reinterpret_cast<int64_t*>(wdata->m_waveformTimestampBuffer.MapRingSegment(offsetBytes));
+		if(!config.dense)
+		{
+			if(digdat)
+				PackSampleOffsets(digdat, count, offsets);
+			else
+				PackSampleOffsets(andat, count, offsets);
+		}
+	}
+	m_geometryBytes += count*sizeof(float) + sizeof(WaveformTransformConfig);
+	if(!config.dense)
+		m_geometryBytes += count*sizeof(int64_t);
+
+	//Reserve space for the output (it's written by the GPU, so we don't need the pointers)
+	wdata->m_waveformStorageBuffer.MapRingSegment(count*2*sizeof(float));
+	wdata->m_waveformIndexBuffer.MapRingSegment(m_width*sizeof(uint32_t));
+
+	m_downloadTime += GetTime() - start;
 	start = GetTime();
 
-	//Download it
-	wdata->m_waveformStorageBuffer.Bind();
-	glBufferData(GL_SHADER_STORAGE_BUFFER, traceBuffer.size()*sizeof(float), &traceBuffer[0], GL_STREAM_DRAW);
+	//Convert samples to pixel coordinates.
+	//Cap the number of blocks, the shader loops over the rest of the samples.
+	size_t localSize = 64;
+	size_t numGroups = (count + localSize - 1) / localSize;
+	if(numGroups > 4096)
+		numGroups = 4096;
+	m_shared->m_waveformTransformProgram.Bind();
+	wdata->m_waveformStorageBuffer.BindBase(0);
+	wdata->m_waveformSampleBuffer.BindBase(1);
+	wdata->m_waveformTransformConfigBuffer.BindBase(2);
+	wdata->m_waveformTimestampBuffer.BindBase(3);
+	m_shared->m_waveformTransformProgram.DispatchCompute(numGroups, 1, 1);
+	m_shared->m_waveformTransformProgram.MemoryBarrier();
+
+	//Build the column index from the transformed coordinates
+	m_shared->m_waveformIndexProgram.Bind();
+	m_shared->m_waveformIndexProgram.SetUniform((int)m_width, "numColumns");
+	m_shared->m_waveformIndexProgram.SetUniform((int)count, "memDepth");
+	wdata->m_waveformStorageBuffer.BindBase(0);
+	wdata->m_waveformIndexBuffer.BindBase(3);
+	m_shared->m_waveformIndexProgram.DispatchCompute((m_width + localSize - 1) / localSize, 1, 1);
+	m_shared->m_waveformIndexProgram.MemoryBarrier();
+
+	//Raw data can be overwritten once these dispatches finish
+	wdata->m_waveformSampleBuffer.FenceRingSegment();
+	wdata->m_waveformTimestampBuffer.FenceRingSegment();
+	wdata->m_waveformTransformConfigBuffer.FenceRingSegment();
+
+	m_indexTime += GetTime() - start;
+}
 
-	//Config stuff
-	uint32_t config[4];
-	config[0] = m_height;							//windowHeight
-	config[1] = m_plotRight;						//windowWidth
-	config[2] = count;								//depth
-	config[3] = m_parent->GetTraceAlpha() * 256;	//alpha
-	wdata->m_waveformConfigBuffer.Bind();
-	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(config), config, GL_STREAM_DRAW);
+/**
+	@brief Flags anything that changed without telling us since the last frame.
 
-	//Indexing
-	wdata->m_waveformIndexBuffer.Bind();
-	glBufferData(GL_SHADER_STORAGE_BUFFER, indexBuffer.size()*sizeof(uint32_t), &indexBuffer[0], GL_STREAM_DRAW);
+	Several places (timeline drags, zooming, the protocol analyzer, eye patterns) move the group's X axis
+	directly, and channel settings can be changed from dialogs, so compare against what was last drawn.
+ */
+void WaveformArea::UpdateDirtyFlags()
+{
+	if( (m_group->m_pixelsPerXUnit != m_lastPixelsPerXUnit) || (m_group->m_xAxisOffset != m_lastXAxisOffset) )
+	{
+		m_lastPixelsPerXUnit = m_group->m_pixelsPerXUnit;
+		m_lastXAxisOffset = m_group->m_xAxisOffset;
+		m_dirty |= DIRTY_X;
+	}
 
-	dt = GetTime() - start;
-	m_downloadTime += dt;
+	float offset = m_channel->GetOffset();
+	if( (m_pixelsPerVolt != m_lastPixelsPerVolt) || (offset != m_lastOffset) )
+	{
+		m_lastPixelsPerVolt = m_pixelsPerVolt;
+		m_lastOffset = offset;
+		m_dirty |= DIRTY_Y;
+	}
 
-	wdata->m_geometryOK = true;
+	//Trace alpha is baked into the accumulated intensities.
+	//Scale what's already drawn rather than redrawing, so persistence survives the change.
+	//Nothing can be scaled back up from zero, so draw the latest waveform again in that case.
+	float alpha = m_parent->GetTraceAlpha();
+	if(alpha != m_lastTraceAlpha)
+	{
+		if(m_lastTraceAlpha > 0)
+		{
+			m_alphaScale = alpha / m_lastTraceAlpha;
+			m_dirty |= DIRTY_ALPHA;
+		}
+		else
+			m_dirty |= DIRTY_DATA;
+		m_lastTraceAlpha = alpha;
+	}
+}
+
+/**
+	@brief Parses a color name, caching the result since Gdk::Color allocates
+ */
+const Gdk::Color& WaveformArea::GetColor(const string& name)
+{
+	auto it = m_colorCache.find(name);
+	if(it == m_colorCache.end())
+		it = m_colorCache.emplace(name, Gdk::Color(name)).first;
+	return it->second;
 }
 
 void WaveformArea::ResetTextureFiltering()
@@ -175,6 +602,7 @@ bool WaveformArea::on_render(const Glib::RefPtr<Gdk::GLContext>& /*context*/)
 {
 	LogIndenter li;
 
+	uint64_t allocStart = GetHeapAllocationCount();
 	double start = GetTime();
 	double dt = start - m_lastFrameStart;
 	if(m_lastFrameStart > 0)
@@ -200,51 +628,72 @@ bool WaveformArea::on_render(const Glib::RefPtr<Gdk::GLContext>& /*context*/)
 	//Pull vertical size from the scope early on no matter how we're rendering
 	m_pixelsPerVolt = m_height / m_channel->GetVoltageRange();
 
-	//TODO: Do persistence processing
+	//Figure out what has to be redone since the last frame
+	UpdateDirtyFlags();
 
-	/*
-	if(!m_persistence || m_persistenceClear)
+	//Launch software rendering passes and push the resulting data to the GPU.
+	//These go first: the underlay decides where the plot area ends, and the overlay pass assigns positions to
+	//protocol decode overlays, and the waveform geometry depends on both.
+	//(The underlay keeps track of its own inputs, so it's always called)
+	ComputeAndDownloadCairoUnderlays();
+	if(m_plotRight != m_lastPlotRight)
 	{
-		m_persistenceClear = false;
+		m_lastPlotRight = m_plotRight;
+		m_dirty |= DIRTY_X;
 	}
-	else
-		RenderPersistenceOverlay();
-	*/
+	ComputeAndDownloadCairoOverlays();
 
 	//Download the main waveform to the GPU and kick off the compute shader for rendering it
+	//With persistence on, every waveform that arrived since the last frame is accumulated in a single pass
+	//on top of the decayed previous contents. Anything that invalidates old pixels starts over from the latest.
+	bool geometryDirty = (m_dirty & (DIRTY_DATA | DIRTY_X | DIRTY_Y)) != 0;
 	if(IsAnalog())
 	{
-		PrepareGeometry(m_waveformRenderData);
-		RenderTrace(m_waveformRenderData);
-	}
+		auto wdata = m_waveformRenderData;
+		if(m_dirty & DIRTY_ALPHA)
+			RescaleTrace(wdata);
 
-	//Launch software rendering passes and push the resulting data to the GPU
-	ComputeAndDownloadCairoUnderlays();
-	ComputeAndDownloadCairoOverlays();
+		bool clearing = m_persistenceClear || (m_dirty & (DIRTY_X | DIRTY_Y));
+		if(m_persistence && !clearing && !wdata->m_batchDescriptors.empty())
+		{
+			PreparePersistenceBatch(wdata);
+			RenderTrace(wdata);
+		}
+		else if(geometryDirty || (m_persistence && m_persistenceClear))
+		{
+			PrepareGeometry(wdata);
+			RenderTrace(wdata);
+			wdata->m_batchGeometry.clear();
+			wdata->m_batchIndex.clear();
+			wdata->m_batchDescriptors.clear();
+		}
+	}
+	m_persistenceClear = false;
 
-	//Do compute shader rendering for digital waveforms
-	for(auto overlay : m_overlays)
+	//Eye patterns and waterfalls are rendered in software, so just push any new data to the GPU.
+	//The image doesn't depend on our own scale or offset, so only new data needs an upload.
+	if(m_dirty & DIRTY_DATA)
 	{
-		if(overlay->GetType() != OscilloscopeChannel::CHANNEL_TYPE_DIGITAL)
-			continue;
-
-		//Create render data if needed
-		//(can't do this when m_waveformRenderData is created because decoders are added later on)
-		if(m_overlayRenderData.find(overlay) == m_overlayRenderData.end())
-			m_overlayRenderData[overlay] = new WaveformRenderData(overlay);
-
-		//Create the texture
-		auto wdat = m_overlayRenderData[overlay];
-		wdat->m_waveformTexture.Bind();
-		wdat->m_waveformTexture.SetData(m_width, m_height, NULL, GL_RGBA, GL_UNSIGNED_BYTE, GL_RGBA32F);
-		ResetTextureFiltering();
+		if(IsEye())
+			UpdateEyeTexture();
+		else if(IsWaterfall())
+			UpdateWaterfallTexture();
+	}
 
-		PrepareGeometry(wdat);
-		RenderTrace(wdat);
+	//Do compute shader rendering for all digital waveforms in one pass
+	if(geometryDirty || (m_dirty & DIRTY_OVERLAYS))
+	{
+		PrepareOverlayGeometry();
+		RenderTrace(m_digitalOverlayRenderData);
 	}
+	else if(m_dirty & DIRTY_ALPHA)
+		RescaleTrace(m_digitalOverlayRenderData);
+
+	//Everything is up to date now
+	m_dirty = 0;
 
 	//Make sure all compute shaders are done before we composite
-	m_waveformComputeProgram.MemoryBarrier();
+	m_shared->m_waveformComputeProgram.MemoryBarrier();
 
 	//Final compositing of data being drawn to the screen
 	m_windowFramebuffer.Bind(GL_FRAMEBUFFER);
@@ -260,6 +709,7 @@ bool WaveformArea::on_render(const Glib::RefPtr<Gdk::GLContext>& /*context*/)
 
 	dt = GetTime() - start;
 	m_renderTime += dt;
+	m_heapAllocations += GetHeapAllocationCount() - allocStart;
 
 	return true;
 }
@@ -282,13 +732,51 @@ void WaveformArea::RenderOverlayTraces()
 	glEnable(GL_SCISSOR_TEST);
 	glScissor(0, 0, m_plotRight, m_height);
 
-	for(auto it : m_overlayRenderData)
-		RenderTraceColorCorrection(it.second);
+	RenderTraceColorCorrection(m_digitalOverlayRenderData);
 
 	glDisable(GL_SCISSOR_TEST);
 }
 
 void WaveformArea::RenderEye()
+{
+	if(m_eyeTextureWidth == 0)
+		return;
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
+
+	m_shared->m_eyeProgram.Bind();
+	m_eyeVAO.Bind();
+	m_shared->m_eyeProgram.SetUniform(m_eyeTexture, "fbtex", 0);
+	m_shared->m_eyeProgram.SetUniform(m_shared->m_eyeColorRamp[m_parent->GetEyeColor()], "ramp", 1);
+	m_shared->m_eyeProgram.SetUniform(0.0f, "yoffset");
+
+	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+}
+
+/**
+	@brief (Re)allocates the eye/waterfall texture if the image size changed
+
+	@return True if the texture was reallocated (and its contents are now undefined)
+ */
+bool WaveformArea::ResizeEyeTexture(size_t width, size_t height)
+{
+	m_eyeTexture.Bind();
+	if( (width == m_eyeTextureWidth) && (height == m_eyeTextureHeight) )
+		return false;
+
+	ResetTextureFiltering();
+	m_eyeTexture.SetData(width, height, NULL, GL_RED, GL_FLOAT, GL_R32F);
+	m_eyeTextureWidth = width;
+	m_eyeTextureHeight = height;
+	return true;
+}
+
+/**
+	@brief Pushes a new eye pattern to the GPU. Only called when the eye has actually changed.
+ */
+void WaveformArea::UpdateEyeTexture()
 {
 	auto peye = dynamic_cast<EyeDecoder2*>(m_channel);
 	auto pcap = dynamic_cast<EyeCapture2*>(m_channel->GetData());
@@ -297,30 +785,47 @@ void WaveformArea::RenderEye()
 	if(pcap == NULL)
 		return;
 
+	double start = GetTime();
+
 	//It's an eye pattern! Just copy it directly into the waveform texture.
-	m_eyeTexture.Bind();
-	ResetTextureFiltering();
-	m_eyeTexture.SetData(
-		peye->GetWidth(),
-		peye->GetHeight(),
-		pcap->GetData(),
-		GL_RED,
-		GL_FLOAT,
-		GL_RGBA32F);
+	size_t width = peye->GetWidth();
+	size_t height = peye->GetHeight();
+	size_t size = width * height * sizeof(float);
+	ResizeEyeTexture(width, height);
+	memcpy(m_eyePixelBuffer.Map(size), pcap->GetData(), size);
+	m_eyePixelBuffer.Unmap();
+	m_eyeTexture.SetSubData(0, 0, width, height, NULL, GL_RED, GL_FLOAT);
+	PixelBuffer::Unbind();
+
+	m_texDownloadTime += GetTime() - start;
+}
+
+void WaveformArea::RenderWaterfall()
+{
+	if(m_eyeTextureHeight == 0)
+		return;
 
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
 
-	m_eyeProgram.Bind();
+	m_shared->m_eyeProgram.Bind();
 	m_eyeVAO.Bind();
-	m_eyeProgram.SetUniform(m_eyeTexture, "fbtex", 0);
-	m_eyeProgram.SetUniform(m_eyeColorRamp[m_parent->GetEyeColor()], "ramp", 1);
+	m_shared->m_eyeProgram.SetUniform(m_eyeTexture, "fbtex", 0);
+	m_shared->m_eyeProgram.SetUniform(m_shared->m_eyeColorRamp[m_parent->GetEyeColor()], "ramp", 1);
+
+	//Rotate the ring so the newest line ends up at the top
+	m_shared->m_eyeProgram.SetUniform((m_waterfallHead + 1) * 1.0f / m_eyeTextureHeight, "yoffset");
 
 	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 }
 
-void WaveformArea::RenderWaterfall()
+/**
+	@brief Pushes new lines of the waterfall to the GPU.
+
+	Normally only the line(s) added since the last upload are sent, and written over the oldest rows of the ring.
+ */
+void WaveformArea::UpdateWaterfallTexture()
 {
 	auto pfall = dynamic_cast<WaterfallDecoder*>(m_channel);
 	auto pcap = dynamic_cast<WaterfallCapture*>(m_channel->GetData());
@@ -333,45 +838,47 @@ void WaveformArea::RenderWaterfall()
 	pfall->SetTimeScale(m_group->m_pixelsPerXUnit);
 	pfall->SetTimeOffset(m_group->m_xAxisOffset);
 
-	//Just copy it directly into the waveform texture.
-	m_eyeTexture.Bind();
-	ResetTextureFiltering();
-	m_eyeTexture.SetData(
-		pfall->GetWidth(),
-		pfall->GetHeight(),
-		pcap->GetData(),
-		GL_RED,
-		GL_FLOAT,
-		GL_RGBA32F);
-
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
-
-	m_eyeProgram.Bind();
-	m_eyeVAO.Bind();
-	m_eyeProgram.SetUniform(m_eyeTexture, "fbtex", 0);
-	m_eyeProgram.SetUniform(m_eyeColorRamp[m_parent->GetEyeColor()], "ramp", 1);
+	double start = GetTime();
 
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-}
+	size_t width = pfall->GetWidth();
+	size_t height = pfall->GetHeight();
+	const float* data = pcap->GetData();
+	size_t rowsize = width * sizeof(float);
 
-void WaveformArea::RenderPersistenceOverlay()
-{
-	/*
-	m_waveformFramebuffer.Bind(GL_FRAMEBUFFER);
+	//See how much is new. If the texture was reallocated, or the image didn't just scroll (history etc), send all of it.
+	size_t rows = m_waterfallNewLines;
+	m_waterfallNewLines = 0;
+	if(ResizeEyeTexture(width, height))
+		rows = 0;
 
-	//Configure blending
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
-	glBlendColor(0, 0, 0, 0.01);
-	glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
+	if( (rows == 0) || (rows >= height) )
+	{
+		//Ring is lined up with the image: newest line in the top row
+		memcpy(m_eyePixelBuffer.Map(rowsize * height), data, rowsize * height);
+		m_eyePixelBuffer.Unmap();
+		m_eyeTexture.SetSubData(0, 0, width, height, NULL, GL_RED, GL_FLOAT);
+		m_waterfallHead = height - 1;
+	}
+	else
+	{
+		//New lines go into the ring right after the current head, wrapping around if needed
+		const float* newRows = data + (height - rows)*width;
+		memcpy(m_eyePixelBuffer.Map(rowsize * rows), newRows, rowsize * rows);
+		m_eyePixelBuffer.Unmap();
+
+		size_t first = (m_waterfallHead + 1) % height;
+		size_t n = min(rows, height - first);
+		m_eyeTexture.SetSubData(0, first, width, n, NULL, GL_RED, GL_FLOAT);
+		if(n < rows)
+		{
+			m_eyeTexture.SetSubData(
+				0, 0, width, rows - n, reinterpret_cast<void*>(n * rowsize), GL_RED, GL_FLOAT);
+		}
+		m_waterfallHead = (m_waterfallHead + rows) % height;
+	}
+	PixelBuffer::Unbind();
 
-	//Draw a black overlay with a little bit of alpha (to make old traces decay)
-	m_persistProgram.Bind();
-	m_persistVAO.Bind();
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-	*/
+	m_texDownloadTime += GetTime() - start;
 }
 
 void WaveformArea::RenderTrace(WaveformRenderData* data)
@@ -379,59 +886,128 @@ void WaveformArea::RenderTrace(WaveformRenderData* data)
 	if(!data->m_geometryOK)
 		return;
 
-	//Round thread block size up to next multiple of the local size (must be power of two)
-	int localSize = 2;
+	//Make sure we have a texture of the right size, with a layer per channel
+	size_t layers = data->m_layers.size();
+	if( (data->m_waveformTexture == NULL) || (data->m_textureLayers != layers) )
+	{
+		m_texturePool.Release(data->m_waveformTexture);
+		data->m_waveformTexture = m_texturePool.Acquire(m_width, m_height, layers, GL_R32F);
+		data->m_textureLayers = layers;
+	}
+
+	//Round thread block size up to next multiple of the number of columns per block (must be power of two)
+	int colsPerBlock = 2;
 	int numCols = m_plotRight;
-	if(0 != (numCols % localSize) )
+	if(0 != (numCols % colsPerBlock) )
 	{
-		numCols |= (localSize-1);
+		numCols |= (colsPerBlock-1);
 		numCols ++;
 	}
-	int numGroups = numCols / localSize;
+	int numGroups = numCols / colsPerBlock;
 
-	m_waveformComputeProgram.Bind();
-	m_waveformComputeProgram.SetImageUniform(data->m_waveformTexture, "outputTex");
+	//Each block only covers part of the window height, so tile vertically
+	int tileHeight = 1024;
+	int numTiles = (m_height + tileHeight - 1) / tileHeight;
+
+	m_shared->m_waveformComputeProgram.Bind();
+	m_shared->m_waveformComputeProgram.SetImageUniform(*data->m_waveformTexture, "outputTex", 0, GL_R32F);
 	data->m_waveformStorageBuffer.BindBase(1);
 	data->m_waveformConfigBuffer.BindBase(2);
 	data->m_waveformIndexBuffer.BindBase(3);
-	m_waveformComputeProgram.DispatchCompute(numGroups, 1, 1);
+	data->m_waveformDescriptorBuffer.BindBase(4);
+	m_shared->m_waveformComputeProgram.DispatchCompute(numGroups, numTiles, layers);
+
+	//Geometry can be overwritten once the shader finishes
+	data->m_waveformStorageBuffer.FenceRingSegment();
+	data->m_waveformConfigBuffer.FenceRingSegment();
+	data->m_waveformIndexBuffer.FenceRingSegment();
+	data->m_waveformDescriptorBuffer.FenceRingSegment();
+}
+
+/**
+	@brief Multiplies everything already drawn into a waveform texture by m_alphaScale, without drawing anything new
+
+	This is a pass of waveform-compute.glsl with no waveforms, and the scale factor as the persistence decay.
+ */
+void WaveformArea::RescaleTrace(WaveformRenderData* data)
+{
+	if(!data->m_geometryOK || (data->m_waveformTexture == NULL) )
+		return;
+
+	WriteRenderConfig(data, 0, m_alphaScale);
+	RenderTrace(data);
+
+	//Anything drawn on top this frame has to see the scaled values
+	m_shared->m_waveformComputeProgram.MemoryBarrier();
 }
 
 void WaveformArea::RenderTraceColorCorrection(WaveformRenderData* data)
 {
-	if(!data->m_geometryOK)
+	if(!data->m_geometryOK || (data->m_waveformTexture == NULL) )
 		return;
 
 	//Prepare to render
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 	glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
-	m_colormapProgram.Bind();
+	m_shared->m_colormapProgram.Bind();
 	m_colormapVAO.Bind();
 
 	//Draw the offscreen buffer to the onscreen buffer
 	//as a textured quad. Apply color correction as we do this.
-	Gdk::Color color(data->m_channel->m_displaycolor);
-	m_colormapProgram.SetUniform(data->m_waveformTexture, "fbtex");
-	m_colormapProgram.SetUniform(color.get_red_p(), "r");
-	m_colormapProgram.SetUniform(color.get_green_p(), "g");
-	m_colormapProgram.SetUniform(color.get_blue_p(), "b");
+	m_shared->m_colormapProgram.SetUniform(*data->m_waveformTexture, "fbtex");
 
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	//Composite as many layers per draw as the shader has room for colors
+	float colors[MAX_COMPOSITE_LAYERS * 3];
+	size_t layers = data->m_layers.size();
+	for(size_t first=0; first<layers; first += MAX_COMPOSITE_LAYERS)
+	{
+		size_t n = min(layers - first, (size_t)MAX_COMPOSITE_LAYERS);
+		for(size_t i=0; i<n; i++)
+		{
+			auto& color = GetColor(data->m_layers[first + i]->m_displaycolor);
+			colors[i*3]		= color.get_red_p();
+			colors[i*3 + 1]	= color.get_green_p();
+			colors[i*3 + 2]	= color.get_blue_p();
+		}
+		m_shared->m_colormapProgram.SetUniform((int)first, "firstLayer");
+		m_shared->m_colormapProgram.SetUniform((int)n, "numLayers");
+		m_shared->m_colormapProgram.SetUniformVec3Array(colors, n, "colors");
+
+		glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+	}
 }
 
 void WaveformArea::ComputeAndDownloadCairoUnderlays()
 {
 	double tstart = GetTime();
 
-	//Create the Cairo surface we're drawing on
-	Cairo::RefPtr< Cairo::ImageSurface > surface =
-		Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, m_width, m_height);
-	Cairo::RefPtr< Cairo::Context > cr = Cairo::Context::create(surface);
+	//See if anything the underlay depends on has changed. If not, reuse the old texture.
+	UnderlayKey key;
+	key.m_width				= m_width;
+	key.m_height			= m_height;
+	key.m_voltageRange		= m_channel->GetVoltageRange();
+	key.m_offset			= m_channel->GetOffset();
+	key.m_color				= m_channel->m_displaycolor;
+	key.m_fft				= IsFFT();
+	key.m_trigger			= (m_scope != NULL) && (m_channel->GetIndex() == m_scope->GetTriggerChannelIndex());
+	if(key.m_trigger)
+		key.m_triggerVoltage = m_scope->GetTriggerVoltage();
+	key.m_dragging			= (m_dragState == DRAG_TRIGGER);
+	if(key.m_dragging)
+		key.m_cursorY		= m_cursorY;
+
+	if(key == m_underlayKey)
+	{
+		m_underlayCacheHits ++;
+		m_cairoTime += (GetTime() - tstart);
+		return;
+	}
+	m_underlayCacheMisses ++;
+	m_underlayKey = key;
 
-	//Set up transformation to match GL's bottom-left origin
-	cr->translate(0, m_height);
-	cr->scale(1, -1);
+	auto cr = GetCairoScratchContext();
+	cr->save();
 
 	//Clear to a blank background
 	cr->set_source_rgba(0, 0, 0, 1);
@@ -441,6 +1017,9 @@ void WaveformArea::ComputeAndDownloadCairoUnderlays()
 	//Software rendering
 	DoRenderCairoUnderlays(cr);
 
+	cr->restore();
+	m_cairoSurface->flush();
+
 	m_cairoTime += (GetTime() - tstart);
 	tstart = GetTime();
 
@@ -451,7 +1030,7 @@ void WaveformArea::ComputeAndDownloadCairoUnderlays()
 	m_cairoTexture.SetData(
 		m_width,
 		m_height,
-		surface->get_data());
+		m_cairoSurface->get_data());
 
 	m_texDownloadTime += (GetTime() - tstart);
 }
@@ -463,27 +1042,42 @@ void WaveformArea::RenderCairoUnderlays()
 	glDisable(GL_BLEND);
 
 	//Draw the actual image
-	m_cairoProgram.Bind();
+	m_shared->m_cairoProgram.Bind();
 	m_cairoVAO.Bind();
-	m_cairoProgram.SetUniform(m_cairoTexture, "fbtex");
+	m_shared->m_cairoProgram.SetUniform(m_cairoTexture, "fbtex");
 	m_cairoTexture.Bind();
 	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 
 	m_compositeTime += (GetTime() - tstart);
 }
 
+/**
+	@brief Re-rasterizes whichever overlay layers are out of date.
+
+	Decodes, the channel info box, and cursors are kept in separate textures so that e.g. dragging a cursor
+	doesn't redraw every protocol decode.
+ */
 void WaveformArea::ComputeAndDownloadCairoOverlays()
 {
-	double tstart = GetTime();
+	if(m_dirty & (DIRTY_DATA | DIRTY_X | DIRTY_OVERLAYS))
+		ComputeAndDownloadCairoLayer(m_cairoTextureDecodes, &WaveformArea::RenderDecodeOverlays);
+	if(m_dirty & (DIRTY_DATA | DIRTY_OVERLAYS))
+		ComputeAndDownloadCairoLayer(m_cairoTextureInfoBox, &WaveformArea::RenderChannelLabel);
+	if(m_dirty & (DIRTY_X | DIRTY_CURSORS))
+		ComputeAndDownloadCairoLayer(m_cairoTextureCursors, &WaveformArea::RenderCursors);
+}
 
-	//Create the Cairo surface we're drawing on
-	Cairo::RefPtr< Cairo::ImageSurface > surface =
-		Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, m_width, m_height);
-	Cairo::RefPtr< Cairo::Context > cr = Cairo::Context::create(surface);
+/**
+	@brief Renders a single transparent overlay layer with Cairo and uploads it to a texture
+ */
+void WaveformArea::ComputeAndDownloadCairoLayer(
+	Texture& tex,
+	void (WaveformArea::*render)(Cairo::RefPtr< Cairo::Context > cr))
+{
+	double tstart = GetTime();
 
-	//Set up transformation to match GL's bottom-left origin
-	cr->translate(0, m_height);
-	cr->scale(1, -1);
+	auto cr = GetCairoScratchContext();
+	cr->save();
 
 	//Clear to a blank background
 	cr->set_source_rgba(0, 0, 0, 0);
@@ -492,19 +1086,22 @@ void WaveformArea::ComputeAndDownloadCairoOverlays()
 	cr->fill();
 	cr->set_operator(Cairo::OPERATOR_OVER);
 
-	DoRenderCairoOverlays(cr);
+	(this->*render)(cr);
+
+	cr->restore();
+	m_cairoSurface->flush();
 
 	m_cairoTime += GetTime() - tstart;
 	tstart = GetTime();
 
 	//Get the image data and make a texture from it
 	//Tell GL it's RGBA even though it's BGRA, faster to invert in the shader than when downloading
-	m_cairoTextureOver.Bind();
+	tex.Bind();
 	ResetTextureFiltering();
-	m_cairoTextureOver.SetData(
+	tex.SetData(
 		m_width,
 		m_height,
-		surface->get_data());
+		m_cairoSurface->get_data());
 
 	m_texDownloadTime += GetTime() - tstart;
 }
@@ -518,17 +1115,49 @@ void WaveformArea::RenderCairoOverlays()
 	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 	glBlendEquationSeparate(GL_FUNC_ADD, GL_FUNC_ADD);
 
-	//Draw the actual image
 	m_windowFramebuffer.Bind(GL_FRAMEBUFFER);
-	m_cairoTextureOver.Bind();
-	m_cairoProgram.Bind();
+	m_shared->m_cairoProgram.Bind();
 	m_cairoVAO.Bind();
-	m_cairoProgram.SetUniform(m_cairoTextureOver, "fbtex");
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+
+	//Draw the layers bottom to top, skipping any that are known to be empty
+	if(!m_overlays.empty())
+		RenderCairoLayer(m_cairoTextureDecodes);
+	RenderCairoLayer(m_cairoTextureInfoBox);
+	if(m_group->m_cursorConfig != WaveformGroup::CURSOR_NONE)
+		RenderCairoLayer(m_cairoTextureCursors);
 
 	m_compositeTime += GetTime() - tstart;
 }
 
+/**
+	@brief Gets the Cairo context used for all software rendering passes, set up with GL's
+	bottom-left origin.
+
+	The surface is shared between passes (each one is uploaded to its texture before the next runs) and is only
+	reallocated when the window size changes.
+ */
+Cairo::RefPtr< Cairo::Context > WaveformArea::GetCairoScratchContext()
+{
+	if(!m_cairoSurface || (m_cairoSurface->get_width() != m_width) || (m_cairoSurface->get_height() != m_height) )
+	{
+		m_cairoSurface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, m_width, m_height);
+		m_cairoContext = Cairo::Context::create(m_cairoSurface);
+
+		//Set up transformation to match GL's bottom-left origin
+		m_cairoContext->translate(0, m_height);
+		m_cairoContext->scale(1, -1);
+	}
+
+	return m_cairoContext;
+}
+
+void WaveformArea::RenderCairoLayer(Texture& tex)
+{
+	tex.Bind();
+	m_shared->m_cairoProgram.SetUniform(tex, "fbtex");
+	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+}
+
 int64_t WaveformArea::XPositionToXAxisUnits(float pix)
 {
 	return m_group->m_xAxisOffset + PixelsToXAxisUnits(pix);
@@ -34,10 +34,15 @@
  */
 #include "glscopeclient.h"
 #include "WaveformGroup.h"
+#include "WaveformArea.h"
 #include "MeasurementDialog.h"
+#include "DecoderCache.h"
 
 using namespace std;
 
+extern ThreadPool* g_threadPool;
+extern CaptureLeases g_captureLeases;
+
 int WaveformGroup::m_numGroups = 1;
 
 WaveformGroup::WaveformGroup(OscilloscopeWindow* parent)
@@ -45,6 +50,11 @@ WaveformGroup::WaveformGroup(OscilloscopeWindow* parent)
 	, m_pixelsPerXUnit(0.05)
 	, m_xAxisOffset(0)
 	, m_cursorConfig(CURSOR_NONE)
+	, m_measurementsPending(0)
+	, m_batch(NULL)
+	, m_nextBatch(NULL)
+	, m_batchesSkipped(0)
+	, m_measurementTickPending(false)
 	, m_parent(parent)
 {
 	////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -76,6 +86,10 @@ WaveformGroup::WaveformGroup(OscilloscopeWindow* parent)
 		m_removeMeasurementItem.set_label("Remove measurement");
 		m_removeMeasurementItem.signal_activate().connect(
 			sigc::mem_fun(*this, &WaveformGroup::OnRemoveMeasurementItem));
+	m_contextMenu.append(m_resetStatisticsItem);
+		m_resetStatisticsItem.set_label("Reset statistics");
+		m_resetStatisticsItem.signal_activate().connect(
+			sigc::mem_fun(*this, &WaveformGroup::OnResetStatisticsItem));
 	m_contextMenu.show_all();
 
 	m_selectedColumn = NULL;
@@ -92,24 +106,318 @@ WaveformGroup::WaveformGroup(OscilloscopeWindow* parent)
 
 WaveformGroup::~WaveformGroup()
 {
+	WaitForMeasurements();
 	for(auto c : m_measurementColumns)
 		delete c;
+
+	if(m_batchesSkipped)
+		LogDebug("%s: %zu measurement batches skipped for a newer waveform\n", m_frame.get_label().c_str(),
+			m_batchesSkipped);
 }
 
+/**
+	@brief Starts all of the measurements running against the waveforms currently loaded.
+
+	Returns without waiting for them. The labels are updated every frame until they're all done.
+
+	Measurements take a lease on the captures their inputs are showing right now rather than copying them, so the
+	channels can move on to the next waveform while they run. If the last batch is still running, this one waits
+	for it instead, replacing any other batch that was already waiting, so the measurements skip waveforms rather
+	than falling behind.
+
+	Measurements looking at a capture that's updated in place (see IsLocal()) can't do either, so they run here
+	before returning.
+ */
 void WaveformGroup::RefreshMeasurements()
 {
+	if(m_measurementColumns.empty())
+		return;
+
+	auto batch = new MeasurementBatch;
+	vector<MeasurementColumn*> local;
+	for(auto m : m_measurementColumns)
+	{
+		if(m->m_local)
+		{
+			local.push_back(m);
+			continue;
+		}
+
+		vector<CaptureChannelBase*> data;
+		for(auto c : m->m_inputs)
+		{
+			auto d = c ? c->GetData() : NULL;
+			g_captureLeases.Acquire(d);
+			data.push_back(d);
+		}
+		batch->m_columns.push_back(m);
+		batch->m_data.push_back(data);
+	}
+
+	if(batch->m_columns.empty())
+		delete batch;
+	else
+	{
+		bool start = false;
+		MeasurementBatch* skipped = NULL;
+		{
+			lock_guard<mutex> lock(m_measurementMutex);
+			if(m_batch == NULL)
+			{
+				m_batch = batch;
+				m_measurementsPending = batch->m_columns.size();
+				start = true;
+			}
+			else
+			{
+				skipped = m_nextBatch;
+				m_nextBatch = batch;
+			}
+		}
+
+		if(start)
+			StartBatch(batch);
+		if(skipped)
+		{
+			ReleaseBatch(skipped);
+			m_batchesSkipped ++;
+		}
+	}
+
+	for(auto m : local)
+		RunMeasurement(m);
+
+	//Update the labels at the next frame rather than every time we get a new waveform
+	if(!m_measurementTickPending)
+	{
+		m_measurementTickPending = true;
+		m_measurementBox.add_tick_callback(sigc::mem_fun(*this, &WaveformGroup::OnMeasurementTick));
+	}
+}
+
+/**
+	@brief Points a batch's snapshots at its captures and submits its measurements to the pool.
+
+	The batch must already be m_batch. Called from the GTK thread, or from the pool when the last batch finishes.
+ */
+void WaveformGroup::StartBatch(MeasurementBatch* batch)
+{
+	for(size_t i=0; i<batch->m_columns.size(); i++)
+	{
+		auto& snapshots = batch->m_columns[i]->m_snapshots;
+		for(size_t j=0; j<snapshots.size(); j++)
+		{
+			if(snapshots[j] == NULL)
+				continue;
+			snapshots[j]->Detach();
+			snapshots[j]->SetData(batch->m_data[i][j]);
+		}
+	}
+
+	for(auto m : batch->m_columns)
+	{
+		g_threadPool->Submit([this, m]
+		{
+			exception_ptr error;
+			try
+			{
+				RunMeasurement(m);
+			}
+			catch(...)
+			{
+				error = current_exception();
+			}
+			OnMeasurementDone(error);
+		});
+	}
+}
+
+/**
+	@brief Called on the pool as each measurement finishes. The last one in a batch starts the next, if any.
+ */
+void WaveformGroup::OnMeasurementDone(exception_ptr error)
+{
+	MeasurementBatch* done;
+	{
+		lock_guard<mutex> lock(m_measurementMutex);
+		if(error && !m_measurementError)
+			m_measurementError = error;
+		m_measurementsPending --;
+		if(m_measurementsPending != 0)
+			return;
+		done = m_batch;
+	}
+
+	//Nothing else touches the snapshots until the next batch starts
+	for(auto m : done->m_columns)
+	{
+		for(auto s : m->m_snapshots)
+		{
+			if(s)
+				s->Detach();
+		}
+	}
+	ReleaseBatch(done);
+
+	MeasurementBatch* next;
+	{
+		lock_guard<mutex> lock(m_measurementMutex);
+		next = m_nextBatch;
+		m_nextBatch = NULL;
+		m_batch = next;
+		if(next)
+			m_measurementsPending = next->m_columns.size();
+		else
+			m_measurementCond.notify_all();
+	}
+
+	if(next)
+		StartBatch(next);
+}
+
+/**
+	@brief Gives up a batch's leases and deletes it
+ */
+void WaveformGroup::ReleaseBatch(MeasurementBatch* batch)
+{
+	for(auto& data : batch->m_data)
+	{
+		for(auto d : data)
+			g_captureLeases.Release(d);
+	}
+	delete batch;
+}
+
+/**
+	@brief Checks if a measurement has to run on the GTK thread, against the real channels.
+
+	Eye patterns and waterfalls add each new waveform to the capture they already have, and packet decoders keep
+	their packet list alongside it, so we can't hang on to their output while they move on. Same rule as the decoder
+	cache, including anything downstream of one of them. Everything else gets a new capture for every waveform.
+ */
+bool WaveformGroup::IsLocal(const vector<OscilloscopeChannel*>& inputs)
+{
+	for(auto c : inputs)
+	{
+		auto decode = dynamic_cast<ProtocolDecoder*>(c);
+		if(decode && !DecoderCache::IsCacheable(decode))
+			return true;
+	}
+	return false;
+}
+
+/**
+	@brief Runs one measurement and records the result for the labels
+ */
+void WaveformGroup::RunMeasurement(MeasurementColumn* m)
+{
+	double start = GetTime();
+	m->m_measurement->Refresh();
+	string value = m->m_measurement->GetValueAsString();
+	double dt = GetTime() - start;
+
+	lock_guard<mutex> lock(m_measurementMutex);
+	m->m_time += dt;
+	m->m_runs ++;
+	m->m_value = value;
+
+	auto fm = dynamic_cast<FloatMeasurement*>(m->m_measurement);
+	if(fm)
+		m->m_stats.Update(fm->GetValue());
+	m->m_changed = true;
+}
+
+/**
+	@brief Blocks until the measurements running on the pool are done. Any batch waiting for them is dropped.
+ */
+void WaveformGroup::WaitForMeasurements()
+{
+	MeasurementBatch* skipped;
+	{
+		unique_lock<mutex> lock(m_measurementMutex);
+		skipped = m_nextBatch;
+		m_nextBatch = NULL;
+		m_measurementCond.wait(lock, [this]{ return m_batch == NULL; });
+	}
+
+	if(skipped)
+		ReleaseBatch(skipped);
+}
+
+bool WaveformGroup::OnMeasurementTick(const Glib::RefPtr<Gdk::FrameClock>& /*clock*/)
+{
+	//Show whatever has finished so far
+	UpdateMeasurementLabels();
+
+	exception_ptr error;
+	bool running;
+	{
+		lock_guard<mutex> lock(m_measurementMutex);
+		error = m_measurementError;
+		m_measurementError = nullptr;
+		running = (m_batch != NULL);
+	}
+
+	//Keep checking every frame until everything we've started is done
+	if(running && !error)
+		return true;
+	m_measurementTickPending = false;
+
+	//Pass on anything that went wrong on the pool, as if the measurement had run here
+	if(error)
+		rethrow_exception(error);
+
+	return false;
+}
+
+/**
+	@brief Shows the latest results of each measurement, and how long it takes to run on average
+ */
+void WaveformGroup::UpdateMeasurementLabels()
+{
+	lock_guard<mutex> lock(m_measurementMutex);
+
 	char tmp[256];
 	for(auto m : m_measurementColumns)
 	{
-		//Run the measurement once, then update our text
-		m->m_measurement->Refresh();
-		snprintf(
-			tmp,
-			sizeof(tmp),
-			"<span font-weight='bold' underline='single'>%s</span>\n"
-			"<span rise='-5' font-family='monospace'>%s</span>",
-			m->m_title.c_str(), m->m_measurement->GetValueAsString().c_str());
-		m->m_label.set_markup(tmp);
+		if(!m->m_changed)
+			continue;
+		m->m_changed = false;
+
+		//Don't bother re-rendering the markup if the value is the same
+		if(m->m_value != m->m_displayedValue)
+		{
+			snprintf(
+				tmp,
+				sizeof(tmp),
+				"<span font-weight='bold' underline='single'>%s</span>\n"
+				"<span rise='-5' font-family='monospace'>%s</span>",
+				m->m_title.c_str(), m->m_value.c_str());
+			m->m_label.set_markup(tmp);
+			m->m_displayedValue = m->m_value;
+		}
+
+		//Statistics and cost go in the tooltip
+		auto& stats = m->m_stats;
+		string tooltip;
+		if(stats.GetCount())
+		{
+			snprintf(tmp, sizeof(tmp),
+				"n = %zu\nmin = %.6g\nmax = %.6g\nmean = %.6g\nstdev = %.6g\n%s\n\n",
+				stats.GetCount(),
+				stats.GetMin(),
+				stats.GetMax(),
+				stats.GetMean(),
+				stats.GetStdDev(),
+				stats.GetHistogramString().c_str());
+			tooltip = tmp;
+		}
+		if(m->m_runs)
+		{
+			snprintf(tmp, sizeof(tmp), "%.3f ms per waveform (%zu runs)", m->m_time * 1000 / m->m_runs, m->m_runs);
+			tooltip += tmp;
+		}
+		m->m_label.set_tooltip_text(tooltip);
 	}
 }
 
@@ -117,6 +425,7 @@ void WaveformGroup::AddColumn(string name, OscilloscopeChannel* chan, string col
 {
 	//Create the measurement itself
 	auto m = Measurement::CreateMeasurement(name);
+	vector<OscilloscopeChannel*> inputs;
 	if(m->GetInputCount() > 1)
 	{
 		MeasurementDialog dialog(m_parent, m, chan);
@@ -126,9 +435,32 @@ void WaveformGroup::AddColumn(string name, OscilloscopeChannel* chan, string col
 			return;
 		}
 		dialog.ConfigureMeasurement();
+		inputs = dialog.GetInputs();
 	}
 	else
-		m->SetInput(0, chan);
+		inputs.push_back(chan);
+
+	//Point it at snapshots of the channels rather than the channels themselves, unless it has to run here anyway
+	bool local = IsLocal(inputs);
+	vector<OscilloscopeChannel*> snapshots;
+	for(size_t i=0; i<inputs.size(); i++)
+	{
+		auto c = inputs[i];
+		if(local)
+		{
+			m->SetInput(i, c);
+			continue;
+		}
+
+		OscilloscopeChannel* snap = NULL;
+		if(c)
+		{
+			snap = new OscilloscopeChannel(NULL, c->GetHwname(), c->GetType(), c->m_displaycolor, c->GetWidth());
+			snap->m_displayname = c->m_displayname;
+		}
+		m->SetInput(i, snap);
+		snapshots.push_back(snap);
+	}
 
 	//Make sure the measurements can actually be seen
 	m_measurementFrame.show();
@@ -150,6 +482,9 @@ void WaveformGroup::AddColumn(string name, OscilloscopeChannel* chan, string col
 	col->m_title = tmp;
 	m_measurementColumns.emplace(col);
 	col->m_measurement = m;
+	col->m_inputs = inputs;
+	col->m_snapshots = snapshots;
+	col->m_local = local;
 
 	//Add to the box and show it
 	m_measurementBox.pack_start(col->m_label, Gtk::PACK_SHRINK, 5);
@@ -166,6 +501,23 @@ void WaveformGroup::AddColumn(string name, OscilloscopeChannel* chan, string col
 	RefreshMeasurements();
 }
 
+/**
+	@brief Redraws cursors in every view in the group after they were moved or reconfigured
+ */
+void WaveformGroup::OnCursorMoved()
+{
+	auto children = m_waveformBox.get_children();
+	for(auto w : children)
+	{
+		auto area = dynamic_cast<WaveformArea*>(w);
+		if(area != NULL)
+			area->SetDirty(WaveformArea::DIRTY_CURSORS);
+	}
+
+	//Redraw everything (timeline included)
+	m_vbox.queue_draw();
+}
+
 bool WaveformGroup::OnMeasurementContextMenu(GdkEventButton* event, MeasurementColumn* col)
 {
 	//SKip anything not right click
@@ -178,8 +530,23 @@ bool WaveformGroup::OnMeasurementContextMenu(GdkEventButton* event, MeasurementC
 	return true;
 }
 
+void WaveformGroup::OnResetStatisticsItem()
+{
+	{
+		lock_guard<mutex> lock(m_measurementMutex);
+		m_selectedColumn->m_stats.Reset();
+		m_selectedColumn->m_changed = true;
+	}
+
+	//Show it now rather than whenever the next waveform shows up
+	UpdateMeasurementLabels();
+}
+
 void WaveformGroup::OnRemoveMeasurementItem()
 {
+	//It might be running, or waiting to
+	WaitForMeasurements();
+
 	m_measurementBox.remove(m_selectedColumn->m_label);
 	m_measurementColumns.erase(m_selectedColumn);
 	delete m_selectedColumn;
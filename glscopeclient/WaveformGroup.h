@@ -37,21 +37,78 @@
 #define WaveformGroup_h
 
 #include "Timeline.h"
+#include "MeasurementStatistics.h"
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 
 class OscilloscopeWindow;
 
 class MeasurementColumn
 {
 public:
+	MeasurementColumn()
+	: m_measurement(NULL)
+	, m_local(false)
+	, m_changed(false)
+	, m_time(0)
+	, m_runs(0)
+	{}
+
 	~MeasurementColumn()
 	{
 		delete m_measurement;
 		m_measurement = NULL;
+
+		//The snapshots only ever borrow their data
+		for(auto s : m_snapshots)
+		{
+			if(s)
+			{
+				s->Detach();
+				delete s;
+			}
+		}
 	}
 
 	Gtk::Label m_label;
 	std::string m_title;
 	Measurement* m_measurement;
+
+	//Channels the measurement was configured with
+	std::vector<OscilloscopeChannel*> m_inputs;
+
+	//What the measurement actually looks at: a channel per input showing the captures its batch leased, so the
+	//real channels can move on to the next waveform while it runs. Empty for local measurements.
+	std::vector<OscilloscopeChannel*> m_snapshots;
+
+	//True if an input updates its capture in place (eye patterns etc), so the measurement has to run on the GTK
+	//thread and looks at the real channels
+	bool m_local;
+
+	//Results from the worker thread, protected by the group's m_measurementMutex
+	std::string m_value;
+	bool m_changed;
+	double m_time;
+	size_t m_runs;
+	MeasurementStatistics m_stats;
+
+	//Last value shown in the label
+	std::string m_displayedValue;
+};
+
+/**
+	@brief Measurements to run on the thread pool against one set of waveforms.
+
+	Holds a lease on every capture in m_data until it's done.
+ */
+class MeasurementBatch
+{
+public:
+	std::vector<MeasurementColumn*> m_columns;
+
+	//The capture each column's snapshots show, by column and then input
+	std::vector< std::vector<CaptureChannelBase*> > m_data;
 };
 
 class WaveformGroup
@@ -61,9 +118,12 @@ public:
 	virtual ~WaveformGroup();
 
 	void RefreshMeasurements();
+	void WaitForMeasurements();
 
 	void AddColumn(std::string name, OscilloscopeChannel* chan, std::string color);
 
+	void OnCursorMoved();
+
 	Gtk::Frame m_frame;
 		Gtk::VBox m_vbox;
 			Timeline m_timeline;
@@ -74,6 +134,7 @@ public:
 
 	Gtk::Menu m_contextMenu;
 		Gtk::MenuItem m_removeMeasurementItem;
+		Gtk::MenuItem m_resetStatisticsItem;
 
 	float m_pixelsPerXUnit;
 	int64_t m_xAxisOffset;
@@ -97,6 +158,32 @@ protected:
 	MeasurementColumn* m_selectedColumn;
 	bool OnMeasurementContextMenu(GdkEventButton* event, MeasurementColumn* col);
 	void OnRemoveMeasurementItem();
+	void OnResetStatisticsItem();
+	bool OnMeasurementTick(const Glib::RefPtr<Gdk::FrameClock>& clock);
+	void UpdateMeasurementLabels();
+	void RunMeasurement(MeasurementColumn* m);
+	void StartBatch(MeasurementBatch* batch);
+	void OnMeasurementDone(std::exception_ptr error);
+	static void ReleaseBatch(MeasurementBatch* batch);
+	static bool IsLocal(const std::vector<OscilloscopeChannel*>& inputs);
+
+	//Measurements running on the thread pool
+	std::mutex m_measurementMutex;
+	std::condition_variable m_measurementCond;
+	size_t m_measurementsPending;
+
+	//The batch running on the pool, if any, and the newest one waiting for it to finish
+	MeasurementBatch* m_batch;
+	MeasurementBatch* m_nextBatch;
+
+	//Batches replaced by a newer one before they got to run (GTK thread only)
+	size_t m_batchesSkipped;
+
+	//First exception thrown by a measurement on the pool, rethrown on the GTK thread once they're all done
+	std::exception_ptr m_measurementError;
+
+	//True if we have a tick callback waiting to update the labels
+	bool m_measurementTickPending;
 
 	static int m_numGroups;
 
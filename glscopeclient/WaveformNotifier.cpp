@@ -0,0 +1,95 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Implementation of WaveformNotifier
+ */
+#include "glscopeclient.h"
+#include "WaveformNotifier.h"
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+WaveformNotifier::WaveformNotifier()
+	: m_tFirstSignal(0)
+{
+	m_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(m_fd < 0)
+	{
+		LogError("Failed to create eventfd for waveform notifications\n");
+		exit(1);
+	}
+}
+
+WaveformNotifier::~WaveformNotifier()
+{
+	close(m_fd);
+}
+
+/**
+	@brief Tells the UI thread that a new waveform is ready. Safe to call from any thread.
+ */
+void WaveformNotifier::Signal()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		if(m_tFirstSignal == 0)
+			m_tFirstSignal = GetTime();
+	}
+
+	uint64_t one = 1;
+	if(write(m_fd, &one, sizeof(one)) != sizeof(one))
+	{
+		//Only fails if the counter would overflow, in which case the UI is already going to wake up
+	}
+}
+
+/**
+	@brief Consumes all pending signals.
+
+	Call before processing the pending waveforms, so that anything which arrives during processing wakes us again.
+
+	@return Time at which the oldest of the consumed signals was sent, or zero if there were none
+ */
+double WaveformNotifier::Clear()
+{
+	uint64_t count;
+	if(read(m_fd, &count, sizeof(count)) != sizeof(count))
+	{
+		//Nothing pending (EAGAIN)
+	}
+
+	lock_guard<mutex> lock(m_mutex);
+	double t = m_tFirstSignal;
+	m_tFirstSignal = 0;
+	return t;
+}
@@ -0,0 +1,63 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Inputs to the waveform rasterizer (waveform-compute.glsl)
+ */
+#ifndef WaveformRenderConfig_h
+#define WaveformRenderConfig_h
+
+#include <stdint.h>
+
+/**
+	@brief One waveform in a (possibly batched) rendering pass. Must match std430 layout in waveform-compute.glsl
+ */
+struct WaveformDescriptor
+{
+	uint32_t	offset;			//Index of the first sample in the geometry buffer
+	uint32_t	depth;			//Number of samples
+	uint32_t	indexOffset;	//Index of the first column in the index buffer
+	uint32_t	weight;			//Intensity added for each hit, in 1/256ths
+	uint32_t	layer;			//Layer of the texture array to draw into
+};
+
+/**
+	@brief Global configuration block for waveform-compute.glsl (must match std430 layout of the shader)
+ */
+struct WaveformRenderConfig
+{
+	uint32_t	windowHeight;
+	uint32_t	windowWidth;
+	uint32_t	numWaveforms;
+	float		persistDecay;
+};
+
+#endif
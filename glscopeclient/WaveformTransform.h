@@ -0,0 +1,141 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Sample to pixel coordinate transform shared by the CPU and GPU geometry paths
+ */
+#ifndef WaveformTransform_h
+#define WaveformTransform_h
+
+#include <stdint.h>
+#include <math.h>
+
+enum WaveformTransformMode
+{
+	TRANSFORM_ANALOG	= 0,
+	TRANSFORM_FFT		= 1,
+	TRANSFORM_DIGITAL	= 2
+};
+
+/**
+	@brief Configuration block for waveform-transform-compute.glsl (must match std430 layout of the shader)
+
+	The CPU geometry path uses the same block and the helpers below, so both paths produce identical coordinates.
+ */
+struct WaveformTransformConfig
+{
+	double		xscale;			//Pixels per capture timestamp unit
+	double		xoff;			//X position of timestamp zero, in pixels
+	double		tstart;			//Timestamp of the first sample (uniform sampling only)
+	double		tstep;			//Timestamp delta between samples (uniform sampling only)
+	float		ybase;			//Y position of zero volts
+	float		pixelsPerVolt;
+	float		offset;			//Channel offset, in volts
+	float		padding;
+	float		plotheight;
+	uint32_t	mode;			//One of WaveformTransformMode
+	uint32_t	memDepth;
+	uint32_t	dense;			//Nonzero if samples are uniformly spaced, and the shader generates the timestamps
+};
+
+/**
+	@brief Converts a timestamp (in capture units) to an X pixel position
+ */
+inline float TransformX(const WaveformTransformConfig& config, int64_t t)
+{
+	return t * config.xscale + config.xoff;
+}
+
+/**
+	@brief Converts a sample value (volts, linear magnitude for spectra, 0/1 for digital) to a Y pixel position
+ */
+inline float TransformY(const WaveformTransformConfig& config, float value)
+{
+	switch(config.mode)
+	{
+		case TRANSFORM_DIGITAL:
+			//TODO: digital overlay stuff
+			return config.ybase + 5 + value*20;
+
+		case TRANSFORM_FFT:
+			{
+				//TODO: don't hard code plot limits
+				float db = -70 - (20 * log10(value));
+				return config.padding - (db/70 * config.plotheight);
+			}
+
+		default:
+			return (config.pixelsPerVolt * (value + config.offset)) + config.ybase;
+	}
+}
+
+/**
+	@brief Copies a capture's sample values into the packed array waveform-transform-compute.glsl reads, checking
+	if the samples are uniformly spaced along the way.
+
+	If they are, config.tstart, tstep and dense are set up for the shader to generate the timestamps itself.
+	Otherwise dense is cleared, and the timestamps have to be uploaded as well (see PackSampleOffsets()).
+ */
+template<class C>
+void PackSampleValues(C* cap, size_t count, float* values, WaveformTransformConfig& config)
+{
+	int64_t tstart = cap->m_samples[0].m_offset;
+	int64_t tstep = 0;
+	if(count > 1)
+		tstep = cap->m_samples[1].m_offset - tstart;
+
+	int dense = 1;
+	#pragma omp parallel for reduction(&:dense)
+	for(size_t j=0; j<count; j++)
+	{
+		auto& sample = cap->m_samples[j];
+		values[j] = sample.m_sample;
+		if(sample.m_offset != tstart + static_cast<int64_t>(j)*tstep)
+			dense = 0;
+	}
+
+	config.tstart	= tstart;
+	config.tstep	= tstep;
+	config.dense	= dense;
+}
+
+/**
+	@brief Copies the timestamps of a capture that isn't uniformly spaced for waveform-transform-compute.glsl
+ */
+template<class C>
+void PackSampleOffsets(C* cap, size_t count, int64_t* offsets)
+{
+	#pragma omp parallel for
+	for(size_t j=0; j<count; j++)
+		offsets[j] = cap->m_samples[j].m_offset;
+}
+
+#endif
@@ -52,13 +52,24 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "AllocationCounter.h"
+#include "BackpressurePolicy.h"
+#include "CaptureLeases.h"
 #include "Framebuffer.h"
+#include "MeasurementStatistics.h"
+#include "PixelBuffer.h"
 #include "Program.h"
+#include "ProgramBinaryCache.h"
+#include "ScopePoller.h"
 #include "Shader.h"
 #include "ShaderStorageBuffer.h"
+#include "SpillWriter.h"
 #include "Texture.h"
+#include "TexturePool.h"
+#include "ThreadPool.h"
 #include "VertexArray.h"
 #include "VertexBuffer.h"
+#include "WaveformNotifier.h"
 
 double GetTime();
 
@@ -35,6 +35,7 @@
 
 #include "glscopeclient.h"
 #include "OscilloscopeWindow.h"
+#include "AcquisitionReactor.h"
 #include "../scopeprotocols/scopeprotocols.h"
 #include "../scopemeasurements/scopemeasurements.h"
 #include "../scopehal/LeCroyVICPOscilloscope.h"
@@ -42,7 +43,9 @@
 #include "../scopehal/RohdeSchwarzOscilloscope.h"
 #include "../scopehal/AntikernelLogicAnalyzer.h"
 #include <thread>
+#include <errno.h>
 #include <libgen.h>
+#include <sys/resource.h>
 
 using namespace std;
 
@@ -51,7 +54,53 @@ int g_numDecodes = 0;
 
 bool g_terminating = false;
 
-void ScopeThread(Oscilloscope* scope);
+//Compute waveform pixel coordinates on the GPU rather than the CPU
+bool g_gpuGeometry = false;
+
+//Signaled by the scope threads whenever a new waveform is ready for the UI
+WaveformNotifier* g_waveformNotifier = NULL;
+
+//Waveforms each instrument's acquisition thread has downloaded and the UI hasn't displayed yet
+map<Oscilloscope*, WaveformQueue*> g_waveformQueues;
+
+//What to do when the UI can't keep up with the instruments
+BackpressureConfig g_backpressureConfig;
+map<Oscilloscope*, BackpressurePolicy*> g_backpressurePolicies;
+
+/**
+	@brief A backpressure option given for one instrument only, applied on top of g_backpressureConfig
+ */
+struct BackpressureOverride
+{
+	string m_nickname;
+	string m_option;
+	string m_value;
+};
+vector<BackpressureOverride> g_backpressureOverrides;
+
+//Max difference between trigger times of waveforms from different scopes that are displayed together, in seconds.
+//Zero to display each scope's waveforms as soon as they arrive.
+double g_syncTolerance = 0;
+
+//Max time a waveform waits for the rest of its sync group before it's dropped, in seconds
+double g_syncTimeout = 1;
+
+//Worker threads for protocol decoders
+ThreadPool* g_threadPool = NULL;
+
+//Refresh protocol decoders on g_threadPool rather than one at a time on the GTK thread
+bool g_parallelRefresh = false;
+
+//Captures measurements on g_threadPool are still looking at
+CaptureLeases g_captureLeases;
+
+//Memory budget for saved protocol decodes of history waveforms, in bytes
+size_t g_decodeCacheBudget = 256 * 1024 * 1024;
+
+//Number of threads polling all instruments through one AcquisitionReactor, or 0 for one thread per instrument
+size_t g_reactorThreads = 0;
+
+void ScopeThread(Oscilloscope* scope, WaveformQueue* queue, BackpressurePolicy* policy);
 
 /**
 	@brief The main application class
@@ -62,6 +111,7 @@ public:
 	ScopeApp()
 	 : Gtk::Application()
 	 , m_window(NULL)
+	 , m_reactor(NULL)
 	{}
 
 	virtual ~ScopeApp();
@@ -80,7 +130,10 @@ protected:
 
 	virtual void on_activate();
 
+	bool OnWaveformReady(Glib::IOCondition condition);
+
 	vector<thread*> m_threads;
+	AcquisitionReactor* m_reactor;
 };
 
 ScopeApp::~ScopeApp()
@@ -90,41 +143,101 @@ ScopeApp::~ScopeApp()
 		t->join();
 		delete t;
 	}
+	delete m_reactor;
 }
 
 void ScopeApp::run()
 {
 	register_application();
-	on_activate();
 
-	while(true)
-	{
-		//Poll the scope to see if we have any new data
-		m_window->PollScopes();
+	g_waveformNotifier = new WaveformNotifier;
+	auto source = Glib::signal_io().connect(
+		sigc::mem_fun(*this, &ScopeApp::OnWaveformReady),
+		g_waveformNotifier->GetFD(),
+		Glib::IO_IN);
 
-		//Dispatch events if we have any
-		while(Gtk::Main::events_pending())
-			Gtk::Main::iteration();
+	on_activate();
 
-		//Stop if the main window got closed
-		if(!m_window->is_visible())
-			break;
-	}
+	//Sleep until we have either new waveforms or GTK events to process.
+	//Stop once the main window gets closed.
+	double tstart = GetTime();
+	while(m_window->is_visible())
+		Gtk::Main::iteration(true);
+	double dt = GetTime() - tstart;
 
 	g_terminating = true;
+	source.disconnect();
+
+	//Report how much CPU we burned, to help spot busy loops
+	rusage usage;
+	if(0 == getrusage(RUSAGE_SELF, &usage))
+	{
+		double cpu =
+			usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 +
+			usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+		LogDebug("CPU time: %.3f s in %.3f s wall clock (%.1f%% of a core)\n", cpu, dt, cpu * 100 / dt);
+	}
 
 	delete m_window;
 	m_window = NULL;
 }
 
+/**
+	@brief Handles a notification from a scope thread that there's new data to display
+ */
+bool ScopeApp::OnWaveformReady(Glib::IOCondition /*condition*/)
+{
+	double tsignal = g_waveformNotifier->Clear();
+	m_window->PollScopes(tsignal);
+	return true;
+}
+
 /**
 	@brief Create windows for each instrument
  */
 void ScopeApp::on_activate()
 {
 	//Start the scope threads
+	//Create the queues before anyone can use them, after this the map is read only
 	for(auto scope : m_scopes)
-		m_threads.push_back(new thread(ScopeThread, scope));
+	{
+		BackpressureConfig config = g_backpressureConfig;
+		for(auto& o : g_backpressureOverrides)
+		{
+			if(o.m_nickname == scope->m_nickname)
+				config.SetOption(o.m_option, o.m_value);
+		}
+
+		g_waveformQueues[scope] = new WaveformQueue;
+		g_backpressurePolicies[scope] = new BackpressurePolicy(config, scope, g_waveformQueues[scope]);
+		LogDebug("Backpressure policy for %s: %s, limits %zu waveforms / %zu bytes\n",
+			scope->m_nickname.c_str(),
+			config.GetDescription().c_str(),
+			config.m_maxWaveforms,
+			config.m_maxBytes);
+	}
+	for(auto& o : g_backpressureOverrides)
+	{
+		bool found = false;
+		for(auto scope : m_scopes)
+		{
+			if(o.m_nickname == scope->m_nickname)
+				found = true;
+		}
+		if(!found)
+		{
+			LogWarning("--%s given for %s, but there's no instrument by that name\n",
+				o.m_option.c_str(), o.m_nickname.c_str());
+		}
+	}
+
+	if(g_reactorThreads > 0)
+		m_reactor = new AcquisitionReactor(m_scopes, g_reactorThreads);
+	else
+	{
+		for(auto scope : m_scopes)
+			m_threads.push_back(new thread(ScopeThread, scope, g_waveformQueues[scope], g_backpressurePolicies[scope]));
+	}
 
 	//Test application
 	m_window = new OscilloscopeWindow(m_scopes);
@@ -161,6 +274,103 @@ int main(int argc, char* argv[])
 			//ShowVersion();
 			return 0;
 		}
+		else if(s == "--gpu-geometry")
+			g_gpuGeometry = true;
+		else if(s == "--parallel-refresh")
+			g_parallelRefresh = true;
+		else if( (s == "--backpressure") || (s == "--max-pending-waveforms") || (s == "--max-pending-bytes") )
+		{
+			//Either applies to every instrument, or NICK=VALUE for just one of them
+			string option = s.substr(2);
+			string value = (i+1 < argc) ? argv[++i] : "";
+			BackpressureOverride o;
+			size_t eq = value.find('=');
+			if( (eq != string::npos) && (eq < value.find(':')) )
+			{
+				o.m_nickname = value.substr(0, eq);
+				value = value.substr(eq + 1);
+			}
+
+			BackpressureConfig test;
+			if(!test.SetOption(option, value))
+			{
+				if(option == "backpressure")
+					fprintf(stderr, "--backpressure requires one of block, keep-latest, decimate:N, spill:DIR\n");
+				else
+					fprintf(stderr, "%s requires a number\n", s.c_str());
+				return 1;
+			}
+
+			if(o.m_nickname.empty())
+				g_backpressureConfig.SetOption(option, value);
+			else
+			{
+				o.m_option = option;
+				o.m_value = value;
+				g_backpressureOverrides.push_back(o);
+			}
+		}
+		else if(s == "--sync")
+		{
+			char* end = NULL;
+			double us = (i+1 < argc) ? strtod(argv[++i], &end) : 0;
+			if( (end == NULL) || (*end != '\0') || !(us > 0) || !isfinite(us) )
+			{
+				fprintf(stderr, "--sync requires a positive tolerance in microseconds\n");
+				return 1;
+			}
+			g_syncTolerance = us * 1e-6;
+		}
+		else if(s == "--sync-timeout")
+		{
+			char* end = NULL;
+			double ms = (i+1 < argc) ? strtod(argv[++i], &end) : 0;
+			if( (end == NULL) || (*end != '\0') || !(ms > 0) || !isfinite(ms) )
+			{
+				fprintf(stderr, "--sync-timeout requires a positive time in milliseconds\n");
+				return 1;
+			}
+			g_syncTimeout = ms * 1e-3;
+		}
+		else if(s == "--decode-cache-mb")
+		{
+			if(i+1 >= argc)
+			{
+				fprintf(stderr, "--decode-cache-mb requires an argument\n");
+				return 1;
+			}
+
+			const char* arg = argv[++i];
+			char* end;
+			errno = 0;
+			unsigned long long mb = strtoull(arg, &end, 10);
+			if( (*arg == '\0') || (*arg == '-') || (*end != '\0') || (errno != 0) || (mb > SIZE_MAX / (1024 * 1024)) )
+			{
+				fprintf(stderr, "--decode-cache-mb requires a size in MB (0 disables the cache)\n");
+				return 1;
+			}
+			g_decodeCacheBudget = mb * 1024 * 1024;
+		}
+		else if(s == "--reactor-threads")
+		{
+			if(i+1 >= argc)
+			{
+				fprintf(stderr, "--reactor-threads requires an argument\n");
+				return 1;
+			}
+
+			//Upper bound is checked once we know how many instruments there are
+			const char* arg = argv[++i];
+			char* end;
+			errno = 0;
+			unsigned long n = strtoul(arg, &end, 10);
+			if( (*arg == '\0') || (*arg == '-') || (*end != '\0') || (errno != 0) || (n < 1) )
+			{
+				fprintf(stderr, "--reactor-threads requires a positive number of threads\n");
+				return 1;
+			}
+			g_reactorThreads = n;
+		}
 		else if(s[0] == '-')
 		{
 			fprintf(stderr, "Unrecognized command-line argument \"%s\", use --help\n", s.c_str());
@@ -170,6 +380,14 @@ int main(int argc, char* argv[])
 			scopes.push_back(s);
 	}
 
+	//Reactor threads block on SCPI round trips, so each one can be downloading from a different instrument.
+	//Any more than one per instrument would never have anything to do.
+	if(g_reactorThreads > max(scopes.size(), (size_t)1))
+	{
+		fprintf(stderr, "--reactor-threads must be between 1 and the number of instruments (%zu)\n", scopes.size());
+		return 1;
+	}
+
 	//Set up logging
 	g_log_sinks.emplace(g_log_sinks.begin(), new ColoredSTDLogSink(console_verbosity));
 
@@ -285,7 +503,18 @@ int main(int argc, char* argv[])
 		}
 	}
 
+	g_threadPool = new ThreadPool(thread::hardware_concurrency());
+
 	app->run();
+
+	//Scope threads are joined by the app destructor, after which nobody can signal
+	app.reset();
+	delete g_waveformNotifier;
+	delete g_threadPool;
+	for(auto it : g_waveformQueues)
+		delete it.second;
+	for(auto it : g_backpressurePolicies)
+		delete it.second;
 	return 0;
 }
 
@@ -308,108 +537,17 @@ double GetTime()
 #endif
 }
 
-void ScopeThread(Oscilloscope* scope)
+void ScopeThread(Oscilloscope* scope, WaveformQueue* queue, BackpressurePolicy* policy)
 {
 	#ifndef _WIN32
 	pthread_setname_np(pthread_self(), "ScopeThread");
 	#endif
 
-	uint32_t delay_us = 1000;
-	double tlast = GetTime();
-	size_t npolls = 0;
-	uint32_t delay_max = 500 * 1000;
-	uint32_t delay_min = 250;
-	double dt = 0;
+	ScopePoller poller(scope, queue, policy);
 	while(!g_terminating)
 	{
-		size_t npending = scope->GetPendingWaveformCount();
-
-		//LogDebug("delay = %.2f ms, pending=%zu\n", delay_us * 0.001f, npending );
-
-		//If the queue is too big, stop grabbing data
-		if(npending > 5000)
-		{
-			usleep(50 * 1000);
-			tlast = GetTime();
-			continue;
-		}
-
-		//If the queue is more than 5 sec long, wait for a while before polling any more.
-		//We've gotten ahead of the UI!
-		if(npending*dt > 5)
-		{
-			//LogDebug("Capture thread got 5 sec ahead of UI, pausing\n");
-			usleep(50 * 1000);
-			tlast = GetTime();
-			continue;
-		}
-
-		//If trigger isn't armed, don't even bother polling for a while.
-		if(!scope->IsTriggerArmed())
-		{
-			usleep(50 * 1000);
-			tlast = GetTime();
-			continue;
-		}
-
-		auto stat = scope->PollTrigger();
-
-		if(stat == Oscilloscope::TRIGGER_MODE_TRIGGERED)
-		{
-			//Collect the data, fail if that doesn't work
-			if(!scope->AcquireData(true))
-			{
-				tlast = GetTime();
-				continue;
-			}
-
-			//Measure how long the acquisition took
-			double now = GetTime();
-			dt = now - tlast;
-			tlast = now;
-			//LogDebug("Triggered, dt = %.3f ms (npolls = %zu, delay_ms = %.2f)\n",
-			//	dt*1000, npolls, delay_us * 0.001f);
-
-			//Adjust polling interval so that we poll a handful of times between triggers
-			if(npolls > 5)
-			{
-				delay_us *= 1.5;
-
-				//Don't increase poll interval beyond 500ms. If we hit that point the scope is either insanely slow,
-				//or they're targeting some kind of intermittent signal. Don't add more lag on top of that!
-				if(delay_us > delay_max)
-					delay_us = delay_max;
-			}
-			if(npolls < 2)
-			{
-				delay_us /= 1.5;
-				if(delay_us < delay_min)
-					delay_us = delay_min;
-			}
-
-			//If we have a really high trigger latency (super low bandwidth link?)
-			//then force the delay to be a bit higher so we have time for other threads to get to the scope
-			if(dt > 2000)
-			{
-				if(delay_us < 5000)
-					delay_us = 5000;
-			}
-
-			npolls = 0;
-
-			continue;
-		}
-		npolls ++;
-
-		//We didn't trigger. Wait a while before the next time we poll to avoid hammering slower hardware.
-		usleep(delay_us);
-
-		//If we've polled a ton of times and the delay is tiny, do a big step increase
-		if(npolls > 50)
-		{
-			//LogDebug("Super laggy scope, bumping polling interval\n");
-			delay_us *= 10;
-			npolls = 0;
-		}
+		uint32_t delay_us = poller.Poll();
+		if(delay_us)
+			usleep(delay_us);
 	}
 }
@@ -1,29 +1,29 @@
 #version 130
 
 in vec2 			texcoord;
-uniform sampler2D	fbtex;
-uniform float		r;
-uniform float		g;
-uniform float		b;
+uniform sampler2DArray	fbtex;
+uniform int			firstLayer;
+uniform int			numLayers;
+uniform vec3		colors[16];
 
 out vec4 			finalColor;
 
 void main()
 {
-	//Look up the original color
-	vec4 texcolor = texture(fbtex, vec2(texcoord));
+	//Composite the layers in order, later ones on top
+	finalColor = vec4(0, 0, 0, 0);
+	for(int i=0; i<numLayers; i++)
+	{
+		//Look up the original color
+		vec4 texcolor = texture(fbtex, vec3(texcoord, firstLayer + i));
 
-	//Logarithmic shading
-	float y = pow(texcolor.a, 1.0 / 4);
-	y = min(y, 2);
-	y = max(y, 0);
+		//Logarithmic shading
+		float y = pow(texcolor.r, 1.0 / 4);
+		y = min(y, 2);
+		y = max(y, 0);
 
-	//convert to rgba
-	finalColor.r = r * y;
-	finalColor.g = g * y;
-	finalColor.b = b * y;
-	if(y > 0)
-		finalColor.a = 1;
-	else
-		finalColor.a = 0;
+		//Anything drawn at all is opaque, so it replaces whatever's below it
+		if(y > 0)
+			finalColor = vec4(colors[i] * y, 1);
+	}
 }
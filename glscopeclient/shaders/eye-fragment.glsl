@@ -3,13 +3,14 @@
 in vec2 			texcoord;
 uniform sampler2D	fbtex;
 uniform sampler2D	ramp;
+uniform float		yoffset;		//Rotation of the texture in Y (for waterfalls stored as a ring of rows)
 
 out vec4 			finalColor;
 
 void main()
 {
 	//Look up the intensity value and clamp it
-	vec4 yvec = texture(fbtex, vec2(texcoord));
+	vec4 yvec = texture(fbtex, vec2(texcoord.x, fract(texcoord.y + yoffset)));
 	float y = yvec.r;
 	if(y >= 0.99)
 		y = 0.99;
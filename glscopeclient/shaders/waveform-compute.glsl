@@ -1,16 +1,18 @@
 #version 430
 
-//The output texture (for now, only alpha channel is used)
-layout(binding=0, rgba32f) uniform image2D outputTex;
+//The output texture (single channel intensity, one layer per trace)
+layout(binding=0, r32f) uniform image2DArray outputTex;
 
 //Voltage data
+struct WaveformSample
+{
+	float x;		//x pixel position (fractional)
+	float voltage;	//y value of this sample, in pixels
+};
+
 layout(std430, binding=1) buffer waveform
 {
-	struct
-	{
-		float x;		//x pixel position (fractional)
-		float voltage;	//y value of this sample, in pixels
-	} data[];
+	WaveformSample data[];
 };
 
 //Global configuration for the run
@@ -18,8 +20,8 @@ layout(std430, binding=2) buffer config
 {
 	uint windowHeight;
 	uint windowWidth;
-	uint memDepth;
-	uint alpha_scaled;
+	uint numWaveforms;
+	float persistDecay;		//Scale factor applied to the previous frame's contents, or 0 to overwrite
 };
 
 //Indexes so we know which samples go to which X pixel range
@@ -28,14 +30,32 @@ layout(std430, binding=3) buffer index
 	uint xind[];
 };
 
-//Maximum height of a single waveform, in pixels.
-//This is enough for a nearly fullscreen 4K window so should be plenty.
-#define MAX_HEIGHT		2048
+//Waveforms to accumulate in this pass (one normally, more when batching persistence updates)
+struct WaveformDescriptor
+{
+	uint offset;			//Index of the first sample in data[]
+	uint depth;				//Number of samples
+	uint indexOffset;		//Index of the first column in xind[]
+	uint weight;			//Intensity added for each hit, in 1/256ths
+	uint layer;				//Layer of outputTex to draw into
+};
+
+layout(std430, binding=4) buffer descriptors
+{
+	WaveformDescriptor waveforms[];
+};
+
+//Number of threads cooperating on a single column of pixels (one warp on most hardware)
+#define THREADS_PER_COL	32
 
 //Number of columns of pixels per thread block
 #define COLS_PER_BLOCK	2
 
-layout(local_size_x=COLS_PER_BLOCK, local_size_y=1, local_size_z=1) in;
+//Height of the slice of the window handled by one thread block.
+//Taller windows are split across multiple blocks in Y (gl_WorkGroupID.y).
+#define TILE_HEIGHT		1024
+
+layout(local_size_x=THREADS_PER_COL, local_size_y=COLS_PER_BLOCK, local_size_z=1) in;
 
 //Interpolate a Y coordinate
 float InterpolateY(vec2 left, vec2 right, float slope, float x)
@@ -43,88 +63,89 @@ float InterpolateY(vec2 left, vec2 right, float slope, float x)
 	return left.y + ( (x - left.x) * slope );
 }
 
-/*
-NEW IDEA
-Multiple threads per X coordinate (say, 32 - 1 warp)
-Parallel fetch base[i+z] and atomically increment local memory
-
-Each local has a 2D shared array
-Assuming 96 KB shared memory, we can fit a total of 24K float32 temp pixels
-Assuming 2K max line height, that's up to 12 pixels of width per local
-*/
-
-//Shared buffer for the local working buffer
-shared float g_workingBuffer[COLS_PER_BLOCK][MAX_HEIGHT];
+//Shared buffer for the local working buffer.
+//Fixed point with 8 fractional bits (same scale as the descriptor weights) so we can use integer atomics.
+shared uint g_workingBuffer[COLS_PER_BLOCK][TILE_HEIGHT];
 
 void main()
 {
-	//Abort if window height is too big, or if we're off the end of the window
-	if(windowHeight > MAX_HEIGHT)
-		return;
-	if(gl_GlobalInvocationID.x > windowWidth)
-		return;
-
-	//Save some constants
-	float alpha = float(alpha_scaled) / 256;
-
-	//Clear column to blank in the first thread of the block
-	if(gl_LocalInvocationID.y == 0)
-	{
-		for(uint y=0; y<windowHeight; y++)
-			g_workingBuffer[gl_LocalInvocationID.x][y] = 0;
-	}
+	uint col = gl_WorkGroupID.x * COLS_PER_BLOCK + gl_LocalInvocationID.y;
+	uint lane = gl_LocalInvocationID.x;
+	uint slot = gl_LocalInvocationID.y;
+	uint layer = gl_WorkGroupID.z;
+
+	//Range of rows this block is responsible for
+	int tileBase = int(gl_WorkGroupID.y * TILE_HEIGHT);
+	int tileEnd = min(tileBase + TILE_HEIGHT, int(windowHeight));
+
+	//Clear our column of the tile, spread across all threads for the column
+	for(uint y=lane; y<TILE_HEIGHT; y += THREADS_PER_COL)
+		g_workingBuffer[slot][y] = 0;
 	barrier();
 	memoryBarrierShared();
 
-	//Loop over the waveform, starting at the leftmost point that overlaps this column
-	uint istart = xind[gl_GlobalInvocationID.x];
-	vec2 left = vec2(data[istart].x, data[istart].voltage);
-	vec2 right;
-	for(uint i=istart; i<(memDepth-1); i++)
+	//Don't return early if we're off the end of the window, every thread has to reach the barriers
+	for(uint w=0; (w < numWaveforms) && (col <= windowWidth); w++)
 	{
-		//Fetch coordinates of the current and upcoming sample
-		right = vec2(data[i+1].x, data[i+1].voltage);
-
-		//If the current point is right of us, stop
-		if(left.x > gl_GlobalInvocationID.x + 1)
-			break;
+		uint base = waveforms[w].offset;
+		uint depth = waveforms[w].depth;
+		uint weight = waveforms[w].weight;
+		if( (depth < 2) || (waveforms[w].layer != layer) )
+			continue;
 
-		//If the upcoming point is still left of us, we're not there yet
-		if(right.x < gl_GlobalInvocationID.x)
+		//Each thread handles every THREADS_PER_COL'th line segment, starting at the leftmost one that
+		//overlaps this column. Segment i goes from sample i to sample i+1.
+		float fcol = float(col);
+		uint istart = xind[waveforms[w].indexOffset + col];
+		for(uint i=istart + lane; i<(depth-1); i += THREADS_PER_COL)
 		{
-			left = right;
-			continue;
+			vec2 left = vec2(data[base + i].x, data[base + i].voltage);
+			vec2 right = vec2(data[base + i + 1].x, data[base + i + 1].voltage);
+
+			//If the current point is right of us, stop.
+			//X coordinates are monotonic so all later segments will be too.
+			if(left.x > fcol + 1)
+				break;
+
+			//If the upcoming point is still left of us, we're not there yet
+			if(right.x < fcol)
+				continue;
+
+			//To start, assume we're drawing the entire segment
+			float starty = left.y;
+			float endy = right.y;
+
+			//Interpolate if either end is outside our column
+			float slope = (right.y - left.y) / (right.x - left.x);
+			if(left.x < fcol)
+				starty = InterpolateY(left, right, slope, fcol);
+			if(right.x > fcol + 1)
+				endy = InterpolateY(left, right, slope, fcol + 1);
+
+			//Sort Y coordinates from min to max, and clip to our tile
+			int ymin = max(int(min(starty, endy)), tileBase);
+			int ymax = min(int(max(starty, endy)), tileEnd - 1);
+
+			//Fill in the space between min and max for this segment
+			for(int y=ymin; y <= ymax; y++)
+				atomicAdd(g_workingBuffer[slot][y - tileBase], weight);
+
+			//TODO: antialiasing
 		}
+	}
+	barrier();
+	memoryBarrierShared();
 
-		//To start, assume we're drawing the entire segment
-		float starty = left.y;
-		float endy = right.y;
-
-		//Interpolate if either end is outside our column
-		float slope = (right.y - left.y) / (right.x - left.x);
-		if(left.x < gl_GlobalInvocationID.x)
-			starty = InterpolateY(left, right, slope, gl_GlobalInvocationID.x);
-		if(right.x > gl_GlobalInvocationID.x + 1)
-			endy = InterpolateY(left, right, slope, gl_GlobalInvocationID.x + 1);
-
-		//Sort Y coordinates from min to max
-		int ymin = int(min(starty, endy));
-		int ymax = int(max(starty, endy));
-
-		//Push current point down the pipeline
-		left = right;
-
-		//Fill in the space between min and max for this segment
-		for(int y=ymin; y <= ymax; y++)
+	//Copy working buffer to RGB output, fading out whatever was there before if persistence is on
+	if(col <= windowWidth)
+	{
+		for(int y=tileBase + int(lane); y<tileEnd; y += THREADS_PER_COL)
 		{
-			g_workingBuffer[gl_LocalInvocationID.x][y] += alpha;
+			ivec3 pos = ivec3(col, y, layer);
+			float alpha = float(g_workingBuffer[slot][y - tileBase]) / 256;
+			if(persistDecay > 0)
+				alpha += imageLoad(outputTex, pos).r * persistDecay;
+			imageStore(outputTex, pos, vec4(alpha, 0, 0, 0));
 		}
-
-		//TODO: antialiasing
-		//TODO: decimation at very wide zooms
 	}
-
-	//Copy working buffer to RGB output
-	for(uint y=0; y<windowHeight; y++)
-		imageStore(outputTex, ivec2(gl_GlobalInvocationID.x, y), vec4(0, 0, 0, g_workingBuffer[gl_LocalInvocationID.x][y]));
 }
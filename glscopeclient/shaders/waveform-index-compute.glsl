@@ -0,0 +1,60 @@
+#version 430
+
+//Pixel coordinates of each sample, as written by waveform-transform-compute.glsl
+struct WaveformSample
+{
+	float x;		//x pixel position (fractional)
+	float voltage;	//y value of this sample, in pixels
+};
+
+layout(std430, binding=0) buffer waveform
+{
+	WaveformSample data[];
+};
+
+//Indexes so we know which samples go to which X pixel range
+layout(std430, binding=3) buffer index
+{
+	uint xind[];
+};
+
+uniform int numColumns;
+uniform int memDepth;
+
+#define THREADS_PER_BLOCK	64
+
+layout(local_size_x=THREADS_PER_BLOCK, local_size_y=1, local_size_z=1) in;
+
+void main()
+{
+	int col = int(gl_GlobalInvocationID.x);
+	if(col >= numColumns)
+		return;
+
+	//Default to drawing nothing
+	uint count = uint(memDepth);
+	if(count < 2)
+	{
+		xind[col] = count;
+		return;
+	}
+
+	//X coordinates are monotonic, so binary search for the first sample N
+	//such that sample N+1 ends at or after the start of this column
+	uint low = 0;
+	uint high = count - 1;
+	float target = float(col);
+	while(low < high)
+	{
+		uint mid = low + (high - low)/2;
+		if(data[mid+1].x >= target)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+
+	if(low >= count-1)
+		xind[col] = count;
+	else
+		xind[col] = low;
+}
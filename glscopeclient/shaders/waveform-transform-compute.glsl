@@ -0,0 +1,80 @@
+#version 430
+
+//Output pixel coordinates (same layout waveform-compute.glsl reads)
+struct WaveformSample
+{
+	float x;		//x pixel position (fractional)
+	float voltage;	//y value of this sample, in pixels
+};
+
+layout(std430, binding=0) buffer waveform
+{
+	WaveformSample data[];
+};
+
+//Raw sample values (volts, linear magnitude for spectra, 0/1 for digital)
+layout(std430, binding=1) buffer samples
+{
+	float values[];
+};
+
+//Global configuration for the run
+layout(std430, binding=2) buffer config
+{
+	double xscale;			//pixels per timestamp unit
+	double xoff;			//pixel offset of timestamp zero
+	double tstart;			//timestamp of the first sample (uniform sampling only)
+	double tstep;			//timestamp delta between samples (uniform sampling only)
+	float ybase;			//Y position of zero volts
+	float pixelsPerVolt;
+	float offset;			//channel offset, in volts
+	float padding;
+	float plotheight;
+	uint mode;				//0 = analog, 1 = spectrum (dB), 2 = digital
+	uint memDepth;
+	uint dense;				//nonzero if timestamps are uniformly spaced
+};
+
+//Raw sample timestamps as 64-bit integers split into (low, high) words.
+//Not used if the capture is uniformly sampled.
+layout(std430, binding=3) buffer timestamps
+{
+	uvec2 times[];
+};
+
+#define MODE_ANALOG		0
+#define MODE_FFT		1
+#define MODE_DIGITAL	2
+
+#define THREADS_PER_BLOCK	64
+
+layout(local_size_x=THREADS_PER_BLOCK, local_size_y=1, local_size_z=1) in;
+
+void main()
+{
+	//Grid-stride loop, since deep captures have more samples than we can launch blocks
+	uint stride = gl_NumWorkGroups.x * THREADS_PER_BLOCK;
+	for(uint i=gl_GlobalInvocationID.x; i<memDepth; i += stride)
+	{
+		//Figure out the timestamp of this sample
+		double t;
+		if(dense != 0)
+			t = tstart + tstep*double(i);
+		else
+			t = double(int(times[i].y)) * 4294967296.0lf + double(times[i].x);
+
+		data[i].x = float(t * xscale + xoff);
+
+		//Convert the Y axis
+		float v = values[i];
+		if(mode == MODE_DIGITAL)
+			data[i].voltage = ybase + 5 + v*20;
+		else if(mode == MODE_FFT)
+		{
+			float db = -70 - (20 * log(v) / log(10.0));
+			data[i].voltage = padding - (db/70 * plotheight);
+		}
+		else
+			data[i].voltage = (pixelsPerVolt * (v + offset)) + ybase;
+	}
+}
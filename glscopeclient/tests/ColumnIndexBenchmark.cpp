@@ -0,0 +1,125 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Compares the column index search against the old serial linear scan
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+#include "../ColumnIndex.h"
+
+using namespace std;
+
+static double GetTime()
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1E9;
+}
+
+/**
+	@brief The column index loop PrepareGeometry used before switching to a per-column binary search
+ */
+static void LinearScan(const float* xcoords, size_t count, int width, uint32_t* indexBuffer)
+{
+	size_t nsample = 0;
+	for(int j=0; j<width; j++)
+	{
+		//Default to drawing nothing
+		indexBuffer[j] = count;
+
+		//Move forward until we find a sample that starts in the current column
+		for(; nsample < count-1; nsample ++)
+		{
+			//If the next sample ends after the start of the current pixel. stop
+			if(xcoords[nsample+1] >= j)
+			{
+				indexBuffer[j] = nsample;
+				break;
+			}
+		}
+	}
+}
+
+static void BinarySearch(const float* xcoords, size_t count, int width, uint32_t* indexBuffer)
+{
+	#pragma omp parallel for
+	for(int j=0; j<width; j++)
+		indexBuffer[j] = BinarySearchForGequal(xcoords, count, j);
+}
+
+int main()
+{
+	const size_t depths[] = { 100000, 1000000, 10000000, 50000000 };
+	const int widths[] = { 100, 1920, 3840 };
+	const int iterations = 10;
+
+	printf("%10s %6s %12s %12s %8s\n", "depth", "width", "linear (ms)", "binary (ms)", "speedup");
+
+	int errors = 0;
+	for(auto depth : depths)
+	{
+		for(auto width : widths)
+		{
+			//Spread the capture over the whole plot, with a little bit hanging off each side
+			//and some jitter so the samples aren't perfectly uniform
+			vector<float> xcoords(depth);
+			float scale = (width + 20.0f) / depth;
+			for(size_t i=0; i<depth; i++)
+				xcoords[i] = -10 + (i + (i % 7) * 0.1f) * scale;
+
+			vector<uint32_t> expected(width);
+			vector<uint32_t> actual(width);
+
+			double start = GetTime();
+			for(int i=0; i<iterations; i++)
+				LinearScan(&xcoords[0], depth, width, &expected[0]);
+			double linear = (GetTime() - start) / iterations;
+
+			start = GetTime();
+			for(int i=0; i<iterations; i++)
+				BinarySearch(&xcoords[0], depth, width, &actual[0]);
+			double binary = (GetTime() - start) / iterations;
+
+			if(expected != actual)
+			{
+				printf("Mismatch at depth %zu, width %d\n", depth, width);
+				errors ++;
+			}
+
+			printf("%10zu %6d %12.3f %12.3f %7.1fx\n", depth, width, linear * 1000, binary * 1000, linear / binary);
+		}
+	}
+
+	return errors ? 1 : 0;
+}
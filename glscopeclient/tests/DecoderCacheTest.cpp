@@ -0,0 +1,289 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Tests for DecoderCache: keys follow the captures and configuration upstream, and eviction frees entries
+			unless a measurement still has them leased
+ */
+#include "../glscopeclient.h"
+#include "../DecoderCache.h"
+#include "../../../lib/scopeprotocols/EyeDecoder2.h"
+
+using namespace std;
+
+CaptureLeases g_captureLeases;
+
+static int g_errors = 0;
+
+#define CHECK(x) \
+	if(!(x)) \
+	{ \
+		printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #x); \
+		g_errors ++; \
+	}
+
+static const size_t TEST_DEPTH = 1000;
+
+/**
+	@brief Minimal decoder with one input and one parameter, whose output is a fresh capture every refresh
+ */
+class TestDecoder : public ProtocolDecoder
+{
+public:
+	TestDecoder(OscilloscopeChannel* input)
+		: ProtocolDecoder(OscilloscopeChannel::CHANNEL_TYPE_ANALOG, "#ffffff", CAT_MATH)
+	{
+		m_signalNames.push_back("din");
+		m_channels.push_back(NULL);
+
+		m_parameters["Gain"] = ProtocolDecoderParameter(ProtocolDecoderParameter::TYPE_FLOAT);
+		m_parameters["Gain"].SetFloatVal(1);
+
+		SetInput(0, input);
+	}
+
+	virtual void Refresh()
+	{
+		auto cap = new AnalogCapture;
+		for(size_t i=0; i<TEST_DEPTH; i++)
+			cap->m_samples.push_back(AnalogSample(i, 1, 0));
+		SetData(cap);
+	}
+
+	virtual bool NeedsConfig()
+	{ return false; }
+
+	virtual bool ValidateChannel(size_t /*i*/, OscilloscopeChannel* /*channel*/)
+	{ return true; }
+
+	virtual string GetProtocolName()
+	{ return "Test"; }
+
+	virtual void SetDefaultName()
+	{ m_displayname = "Test"; }
+};
+
+/**
+	@brief Replaces a scope channel's capture with a new one taken at a given time, like selecting a history row
+ */
+static void SetCaptureTime(OscilloscopeChannel* chan, time_t t)
+{
+	auto cap = new AnalogCapture;
+	cap->m_startTimestamp = t;
+	cap->m_startPicoseconds = 0;
+	chan->SetData(cap);
+}
+
+/**
+	@brief Makes a scope channel holding a capture taken at a given time
+ */
+static OscilloscopeChannel* MakeChannel(string name, time_t t)
+{
+	auto chan = new OscilloscopeChannel(NULL, name, OscilloscopeChannel::CHANNEL_TYPE_ANALOG, "#ffffff");
+	SetCaptureTime(chan, t);
+	return chan;
+}
+
+/**
+	@brief Refreshes decoders the way the main window does, handing the cache's captures back to it first
+ */
+static void Refresh(DecoderCache& cache, const set<ProtocolDecoder*>& decoders, const vector<ProtocolDecoder*>& order)
+{
+	cache.Release(decoders);
+	for(auto d : order)
+		d->Refresh();
+	cache.Store(decoders);
+}
+
+/**
+	@brief Hits and misses follow the captures and configuration each decoder depends on, including upstream
+ */
+static void TestKeys()
+{
+	DecoderCache cache(1024 * 1024 * 1024);
+
+	//Two instruments, and a decoder downstream of another
+	auto ch1 = MakeChannel("CH1", 100);
+	auto ch2 = MakeChannel("CH2", 200);
+	auto d1 = new TestDecoder(ch1);
+	auto d2 = new TestDecoder(d1);
+	auto d3 = new TestDecoder(ch2);
+	set<ProtocolDecoder*> all = {d1, d2, d3};
+
+	Refresh(cache, all, {d1, d2, d3});
+	CHECK(cache.GetEntryCount() == 3);
+
+	//Coming back to the same captures hits everything
+	cache.Release(all);
+	CHECK(cache.Load(d1));
+	CHECK(cache.Load(d2));
+	CHECK(cache.Load(d3));
+	CHECK(d2->GetData() != NULL);
+
+	//Changing an upstream parameter changes the downstream decoder's key too
+	d1->GetParameter("Gain").SetFloatVal(2);
+	cache.Release(all);
+	CHECK(!cache.Load(d1));
+	CHECK(!cache.Load(d2));
+	CHECK(cache.Load(d3));
+	d1->GetParameter("Gain").SetFloatVal(1);
+	CHECK(cache.Load(d1));
+	CHECK(cache.Load(d2));
+
+	//A new capture on one instrument only misses the decoders that look at it
+	SetCaptureTime(ch1, 300);
+	cache.Release(all);
+	CHECK(!cache.Load(d1));
+	CHECK(!cache.Load(d2));
+	CHECK(cache.Load(d3));
+
+	//Dropping the first capture from the history frees everything decoded from it, upstream or down
+	size_t before = cache.GetBytesUsed();
+	cache.RemoveTimePoint(TimePoint(100, 0));
+	CHECK(cache.GetEntryCount() == 1);
+	CHECK(cache.GetBytesUsed() < before);
+	SetCaptureTime(ch1, 100);
+	CHECK(!cache.Load(d1));
+	CHECK(!cache.Load(d2));
+
+	//Dropping the other instrument's capture frees the rest
+	cache.RemoveTimePoint(TimePoint(200, 0));
+	CHECK(cache.GetEntryCount() == 0);
+	CHECK(cache.GetBytesUsed() == 0);
+}
+
+/**
+	@brief Going over the budget frees the least recently used entries, but never one being displayed
+ */
+static void TestBudget()
+{
+	//Room for one output, not two
+	DecoderCache cache(3 * TEST_DEPTH * sizeof(AnalogSample) / 2);
+
+	auto ch1 = MakeChannel("CH1", 100);
+	auto d1 = new TestDecoder(ch1);
+	set<ProtocolDecoder*> all = {d1};
+
+	Refresh(cache, all, {d1});
+	CHECK(cache.GetEntryCount() == 1);
+
+	//The new output is displayed so it stays, the old one goes
+	SetCaptureTime(ch1, 200);
+	Refresh(cache, all, {d1});
+	CHECK(cache.GetEntryCount() == 1);
+
+	SetCaptureTime(ch1, 100);
+	cache.Release(all);
+	CHECK(!cache.Load(d1));
+	SetCaptureTime(ch1, 200);
+	CHECK(cache.Load(d1));
+}
+
+/**
+	@brief Eye patterns accumulate across captures, so neither they nor anything downstream get cached
+ */
+static void TestStateful()
+{
+	DecoderCache cache(1024 * 1024 * 1024);
+
+	auto ch1 = MakeChannel("CH1", 100);
+	auto eye = new EyeDecoder2("#ffffff");
+	eye->SetInput(0, ch1);
+	auto d1 = new TestDecoder(eye);
+
+	CHECK(!DecoderCache::IsCacheable(eye));
+	CHECK(!DecoderCache::IsCacheable(d1));
+
+	Refresh(cache, {d1}, {d1});
+	CHECK(cache.GetEntryCount() == 0);
+
+	//Release must leave it alone
+	auto data = d1->GetData();
+	cache.Release({d1});
+	CHECK(d1->GetData() == data);
+}
+
+/**
+	@brief Captures a measurement has leased outlive both the cache dropping them and the decoder replacing them
+ */
+static void TestLeases()
+{
+	//Room for one output, not two
+	DecoderCache cache(3 * TEST_DEPTH * sizeof(AnalogSample) / 2);
+
+	auto ch1 = MakeChannel("CH1", 100);
+	auto d1 = new TestDecoder(ch1);
+	set<ProtocolDecoder*> all = {d1};
+
+	//Evicted from the cache while leased
+	Refresh(cache, all, {d1});
+	auto first = dynamic_cast<AnalogCapture*>(d1->GetData());
+	g_captureLeases.Acquire(first);
+	SetCaptureTime(ch1, 200);
+	Refresh(cache, all, {d1});
+	CHECK(cache.GetEntryCount() == 1);
+	CHECK(g_captureLeases.IsLeased(first));
+	CHECK(first->m_samples.size() == TEST_DEPTH);
+	g_captureLeases.Release(first);
+
+	//Replaced by a decoder the cache doesn't hold the output of
+	auto eye = new EyeDecoder2("#ffffff");
+	eye->SetInput(0, ch1);
+	auto d2 = new TestDecoder(eye);
+	d2->Refresh();
+	auto second = dynamic_cast<AnalogCapture*>(d2->GetData());
+	g_captureLeases.Acquire(second);
+	g_captureLeases.DetachIfLeased(d2);
+	CHECK(d2->GetData() == NULL);
+	d2->Refresh();
+	CHECK(second->m_samples.size() == TEST_DEPTH);
+	g_captureLeases.Release(second);
+
+	//Nothing leased, so nothing to take away
+	auto third = d2->GetData();
+	g_captureLeases.DetachIfLeased(d2);
+	CHECK(d2->GetData() == third);
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+	TestKeys();
+	TestBudget();
+	TestStateful();
+	TestLeases();
+
+	if(g_errors)
+	{
+		printf("%d checks failed\n", g_errors);
+		return 1;
+	}
+	return 0;
+}
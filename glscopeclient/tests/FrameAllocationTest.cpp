@@ -0,0 +1,267 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Renders frames through the same GL objects WaveformArea::on_render uses and checks that the GL side of a
+			steady-state frame makes no heap allocations.
+
+	Covers the geometry rings, column index, compute rasterization into a pooled texture, colormap compositing,
+	and the eye pattern PBO upload. Must be built with COUNT_HEAP_ALLOCATIONS.
+
+	This is a stand-in for the frame loop, not WaveformArea itself, which needs a realized GTK widget. The Cairo
+	overlays (grid, channel labels, cursors, decodes) and renderer creation are not exercised here, only the GL path.
+ */
+#include "../glscopeclient.h"
+#include "../ColumnIndex.h"
+#include "../WaveformRenderConfig.h"
+#include "../WaveformTransform.h"
+#include "GLTestContext.h"
+
+using namespace std;
+
+#ifndef COUNT_HEAP_ALLOCATIONS
+#error FrameAllocationTest needs COUNT_HEAP_ALLOCATIONS to be defined
+#endif
+
+//Same settings as WaveformArea::RenderTrace
+#define COLS_PER_BLOCK	2
+#define TILE_HEIGHT		1024
+
+/**
+	@brief Everything that persists from one frame to the next, like the members of WaveformArea and
+	WaveformRenderData
+ */
+class FrameState
+{
+public:
+	int m_width;
+	int m_height;
+	WaveformTransformConfig m_transform;
+	AnalogCapture m_capture;
+	vector<float> m_xCoords;
+	vector<float> m_eye;
+
+	Program m_computeProgram;
+	Program m_colormapProgram;
+
+	ShaderStorageBuffer m_geometryBuffer;
+	ShaderStorageBuffer m_configBuffer;
+	ShaderStorageBuffer m_indexBuffer;
+	ShaderStorageBuffer m_descriptorBuffer;
+	TexturePool m_texturePool;
+	Texture* m_waveformTexture;
+
+	Framebuffer m_framebuffer;
+	Texture m_framebufferTexture;
+	VertexArray m_colormapVAO;
+	VertexBuffer m_colormapVBO;
+
+	PixelBuffer m_eyePixelBuffer;
+	Texture m_eyeTexture;
+};
+
+static bool LoadProgram(Program& prog, vector<pair<GLenum, string> > shaders)
+{
+	for(auto& s : shaders)
+	{
+		Shader shader(s.first);
+		if(!shader.Load(string(SHADER_DIR) + "/" + s.second))
+			return false;
+		prog.Add(shader);
+	}
+	return prog.Link();
+}
+
+static bool Initialize(FrameState& s)
+{
+	s.m_width = 1024;
+	s.m_height = 512;
+
+	if(!LoadProgram(s.m_computeProgram, {{GL_COMPUTE_SHADER, "waveform-compute.glsl"}}))
+		return false;
+	if(!LoadProgram(s.m_colormapProgram, {
+		{GL_VERTEX_SHADER, "colormap-vertex.glsl"},
+		{GL_FRAGMENT_SHADER, "colormap-fragment.glsl"}}))
+	{
+		return false;
+	}
+
+	//Offscreen stand-in for the window surface
+	s.m_framebufferTexture.Bind();
+	s.m_framebufferTexture.SetData(s.m_width, s.m_height);
+	s.m_framebuffer.Bind(GL_FRAMEBUFFER);
+	s.m_framebuffer.SetTexture(s.m_framebufferTexture);
+	if(!s.m_framebuffer.IsComplete())
+	{
+		printf("Framebuffer incomplete\n");
+		return false;
+	}
+
+	//Fullscreen quad for compositing, as in WaveformArea::InitializeColormapPass
+	float verts[8] = { -1, -1, 1, -1, 1, 1, -1, 1 };
+	s.m_colormapVBO.Bind();
+	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+	s.m_colormapVAO.Bind();
+	s.m_colormapProgram.EnableVertexArray("vert");
+	s.m_colormapProgram.SetVertexAttribPointer("vert", 2, 0);
+
+	for(size_t i=0; i<500000; i++)
+		s.m_capture.m_samples.push_back(AnalogSample(i, 1, sin(i * 0.0001f) * 0.8f));
+
+	s.m_transform.xscale		= s.m_width * 1.0 / s.m_capture.GetDepth();
+	s.m_transform.xoff			= 0;
+	s.m_transform.ybase			= s.m_height / 2;
+	s.m_transform.pixelsPerVolt	= s.m_height / 2;
+	s.m_transform.offset		= 0;
+	s.m_transform.padding		= 2;
+	s.m_transform.plotheight	= s.m_height - 4;
+	s.m_transform.mode			= TRANSFORM_ANALOG;
+	s.m_transform.memDepth		= s.m_capture.GetDepth();
+
+	s.m_eye.resize(s.m_width * s.m_height);
+	s.m_eyeTexture.Bind();
+	s.m_eyeTexture.SetData(s.m_width, s.m_height, NULL, GL_RED, GL_FLOAT, GL_R32F);
+
+	s.m_waveformTexture = NULL;
+	return true;
+}
+
+static void RenderFrame(FrameState& s)
+{
+	size_t count = s.m_capture.GetDepth();
+
+	//Geometry and index, as in WaveformArea::PrepareGeometry
+	auto trace = reinterpret_cast<float*>(s.m_geometryBuffer.MapRingSegment(count*2*sizeof(float)));
+	auto index = reinterpret_cast<uint32_t*>(s.m_indexBuffer.MapRingSegment(s.m_width*sizeof(uint32_t)));
+	s.m_xCoords.resize(count);
+	for(size_t i=0; i<count; i++)
+	{
+		float x = TransformX(s.m_transform, s.m_capture.GetSampleStart(i));
+		trace[i*2] = x;
+		s.m_xCoords[i] = x;
+		trace[i*2 + 1] = TransformY(s.m_transform, s.m_capture[i]);
+	}
+	for(int i=0; i<s.m_width; i++)
+		index[i] = BinarySearchForGequal(&s.m_xCoords[0], count, i);
+
+	auto desc = reinterpret_cast<WaveformDescriptor*>(s.m_descriptorBuffer.MapRingSegment(sizeof(WaveformDescriptor)));
+	desc->offset		= 0;
+	desc->depth			= count;
+	desc->indexOffset	= 0;
+	desc->weight		= 256;
+	desc->layer			= 0;
+	auto config = reinterpret_cast<WaveformRenderConfig*>(s.m_configBuffer.MapRingSegment(sizeof(WaveformRenderConfig)));
+	config->windowHeight	= s.m_height;
+	config->windowWidth		= s.m_width;
+	config->numWaveforms	= 1;
+	config->persistDecay	= 0;
+
+	//Rasterize, as in WaveformArea::RenderTrace. Cycle the texture through the pool like a resize would.
+	s.m_texturePool.Release(s.m_waveformTexture);
+	s.m_waveformTexture = s.m_texturePool.Acquire(s.m_width, s.m_height, 1, GL_R32F);
+	s.m_computeProgram.Bind();
+	s.m_computeProgram.SetImageUniform(*s.m_waveformTexture, "outputTex", 0, GL_R32F);
+	s.m_geometryBuffer.BindBase(1);
+	s.m_configBuffer.BindBase(2);
+	s.m_indexBuffer.BindBase(3);
+	s.m_descriptorBuffer.BindBase(4);
+	s.m_computeProgram.DispatchCompute(s.m_width / COLS_PER_BLOCK, (s.m_height + TILE_HEIGHT - 1) / TILE_HEIGHT, 1);
+	s.m_geometryBuffer.FenceRingSegment();
+	s.m_configBuffer.FenceRingSegment();
+	s.m_indexBuffer.FenceRingSegment();
+	s.m_descriptorBuffer.FenceRingSegment();
+	s.m_computeProgram.MemoryBarrier();
+
+	//Composite, as in WaveformArea::RenderTraceColorCorrection
+	float colors[3] = { 1, 1, 0 };
+	s.m_framebuffer.Bind(GL_FRAMEBUFFER);
+	glViewport(0, 0, s.m_width, s.m_height);
+	s.m_colormapProgram.Bind();
+	s.m_colormapVAO.Bind();
+	s.m_colormapProgram.SetUniform(*s.m_waveformTexture, "fbtex");
+	s.m_colormapProgram.SetUniform(0, "firstLayer");
+	s.m_colormapProgram.SetUniform(1, "numLayers");
+	s.m_colormapProgram.SetUniformVec3Array(colors, 1, "colors");
+	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+
+	//Eye pattern upload, as in WaveformArea::UpdateEyeTexture
+	size_t size = s.m_eye.size() * sizeof(float);
+	memcpy(s.m_eyePixelBuffer.Map(size), &s.m_eye[0], size);
+	s.m_eyePixelBuffer.Unmap();
+	s.m_eyeTexture.Bind();
+	s.m_eyeTexture.SetSubData(0, 0, s.m_width, s.m_height, NULL, GL_RED, GL_FLOAT);
+	PixelBuffer::Unbind();
+
+	glFinish();
+}
+
+int main()
+{
+	if(!InitTestContext())
+	{
+		printf("No OpenGL 4.3 context available, skipping\n");
+		return TEST_SKIPPED;
+	}
+
+	FrameState state;
+	if(!Initialize(state))
+		return 1;
+
+	//The first few frames allocate rings, pooled textures, and uniform location caches
+	const int warmup = 3;
+	const int frames = 50;
+	for(int i=0; i<warmup; i++)
+		RenderFrame(state);
+
+	int errors = 0;
+	for(int i=0; i<frames; i++)
+	{
+		uint64_t start = GetHeapAllocationCount();
+		RenderFrame(state);
+		uint64_t allocs = GetHeapAllocationCount() - start;
+		if(allocs != 0)
+		{
+			printf("Frame %d: %lu heap allocations\n", i, (unsigned long)allocs);
+			errors ++;
+		}
+	}
+
+	GLenum err = glGetError();
+	if(err != GL_NO_ERROR)
+	{
+		printf("GL error %x\n", err);
+		errors ++;
+	}
+
+	state.m_texturePool.Release(state.m_waveformTexture);
+	printf("%d frames, %d with heap allocations\n", frames, errors);
+	return errors ? 1 : 0;
+}
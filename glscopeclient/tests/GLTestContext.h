@@ -0,0 +1,167 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Headless OpenGL context and helpers for tests that run shaders
+ */
+#ifndef GLTestContext_h
+#define GLTestContext_h
+
+#define GL_GLEXT_PROTOTYPES
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <stdio.h>
+#include <string>
+
+//ctest treats this exit code as "skipped" (see SKIP_RETURN_CODE in CMakeLists.txt)
+#define TEST_SKIPPED 77
+
+/**
+	@brief Creates a GL 4.3 core context with no window, using EGL's surfaceless platform.
+
+	Works with Mesa's software rasterizer (LIBGL_ALWAYS_SOFTWARE=1) so shader tests can run without a GPU.
+
+	@return False if no suitable context could be created
+ */
+inline bool InitTestContext()
+{
+	auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+		eglGetProcAddress("eglGetPlatformDisplayEXT"));
+	if(!getPlatformDisplay)
+		return false;
+	EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	if(display == EGL_NO_DISPLAY)
+		return false;
+
+	EGLint major;
+	EGLint minor;
+	if(!eglInitialize(display, &major, &minor))
+		return false;
+	if(!eglBindAPI(EGL_OPENGL_API))
+		return false;
+
+	EGLint attribs[] =
+	{
+		EGL_CONTEXT_MAJOR_VERSION,			4,
+		EGL_CONTEXT_MINOR_VERSION,			3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK,	EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+	EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attribs);
+	if(context == EGL_NO_CONTEXT)
+		return false;
+	if(!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+		return false;
+
+	printf("Using %s (%s)\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+	return true;
+}
+
+/**
+	@brief Compiles and links a compute shader from the glscopeclient shader directory
+
+	@return The program handle, or 0 on failure
+ */
+inline GLuint LoadComputeProgram(const std::string& name)
+{
+	std::string path = std::string(SHADER_DIR) + "/" + name;
+	FILE* fp = fopen(path.c_str(), "rb");
+	if(!fp)
+	{
+		printf("Could not open %s\n", path.c_str());
+		return 0;
+	}
+	std::string source;
+	char buf[4096];
+	size_t len;
+	while( (len = fread(buf, 1, sizeof(buf), fp)) > 0)
+		source.append(buf, len);
+	fclose(fp);
+
+	GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+	const char* src = source.c_str();
+	glShaderSource(shader, 1, &src, NULL);
+	glCompileShader(shader);
+
+	GLint ok;
+	char log[4096];
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+	if(!ok)
+	{
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		printf("Compile of %s failed:\n%s\n", name.c_str(), log);
+		return 0;
+	}
+
+	GLuint program = glCreateProgram();
+	glAttachShader(program, shader);
+	glLinkProgram(program);
+	glDeleteShader(shader);
+	glGetProgramiv(program, GL_LINK_STATUS, &ok);
+	if(!ok)
+	{
+		glGetProgramInfoLog(program, sizeof(log), NULL, log);
+		printf("Link of %s failed:\n%s\n", name.c_str(), log);
+		return 0;
+	}
+	return program;
+}
+
+/**
+	@brief Creates an SSBO with the given contents (or zeroes, if data is NULL)
+ */
+inline GLuint CreateStorageBuffer(size_t size, const void* data)
+{
+	GLuint buf;
+	glGenBuffers(1, &buf);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buf);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_STATIC_DRAW);
+	if(!data)
+	{
+		GLuint zero = 0;
+		glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+	}
+	return buf;
+}
+
+/**
+	@brief Reads back the contents of an SSBO
+ */
+inline void ReadStorageBuffer(GLuint buf, size_t size, void* data)
+{
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buf);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+}
+
+#endif
@@ -0,0 +1,245 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Checks the GPU geometry path (waveform-transform-compute.glsl and waveform-index-compute.glsl) against
+			the CPU path.
+
+	Run with LIBGL_ALWAYS_SOFTWARE=1 to test under Mesa's software rasterizer.
+ */
+#include "../glscopeclient.h"
+#include "../ColumnIndex.h"
+#include "../WaveformTransform.h"
+#include "GLTestContext.h"
+
+using namespace std;
+
+static GLuint g_transformProgram;
+static GLuint g_indexProgram;
+
+/**
+	@brief Runs one capture through both geometry paths and compares the results
+
+	@param expectDense	True if the capture is uniformly spaced, so the GPU path shouldn't need its timestamps
+
+	@return Number of mismatches
+ */
+static int CompareGeometry(
+	const char* name,
+	CaptureChannelBase* cap,
+	WaveformTransformConfig config,
+	int width,
+	bool expectDense)
+{
+	auto andat = dynamic_cast<AnalogCapture*>(cap);
+	auto digdat = dynamic_cast<DigitalCapture*>(cap);
+	size_t count = cap->GetDepth();
+	config.memDepth = count;
+
+	//CPU path
+	vector<float> xcoords(count);
+	vector<float> ycoords(count);
+	vector<uint32_t> index(width);
+	for(size_t i=0; i<count; i++)
+	{
+		float value;
+		if(digdat)
+			value = (*digdat)[i] ? 1 : 0;
+		else
+			value = (*andat)[i];
+		xcoords[i] = TransformX(config, cap->GetSampleStart(i));
+		ycoords[i] = TransformY(config, value);
+	}
+	for(int i=0; i<width; i++)
+		index[i] = BinarySearchForGequal(&xcoords[0], count, i);
+
+	//GPU path, packed and bound the same way WaveformArea::PrepareGeometryOnGPU does it
+	vector<float> values(count);
+	vector<int64_t> offsets(count);
+	if(digdat)
+		PackSampleValues(digdat, count, &values[0], config);
+	else
+		PackSampleValues(andat, count, &values[0], config);
+	size_t offsetBytes = 0;
+	if(!config.dense)
+	{
+		if(digdat)
+			PackSampleOffsets(digdat, count, &offsets[0]);
+		else
+			PackSampleOffsets(andat, count, &offsets[0]);
+		offsetBytes = count*sizeof(int64_t);
+	}
+
+	GLuint geometryBuffer = CreateStorageBuffer(count*2*sizeof(float), NULL);
+	GLuint sampleBuffer = CreateStorageBuffer(count*sizeof(float), &values[0]);
+	GLuint configBuffer = CreateStorageBuffer(sizeof(config), &config);
+	GLuint timestampBuffer = CreateStorageBuffer(max(offsetBytes, sizeof(int64_t)), &offsets[0]);
+	GLuint indexBuffer = CreateStorageBuffer(width*sizeof(uint32_t), NULL);
+
+	glUseProgram(g_transformProgram);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, geometryBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sampleBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, configBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, timestampBuffer);
+	glDispatchCompute(min((count + 63) / 64, (size_t)4096), 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	glUseProgram(g_indexProgram);
+	glUniform1i(glGetUniformLocation(g_indexProgram, "numColumns"), width);
+	glUniform1i(glGetUniformLocation(g_indexProgram, "memDepth"), count);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, geometryBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, indexBuffer);
+	glDispatchCompute((width + 63) / 64, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	vector<float> geometry(count*2);
+	vector<uint32_t> gpuIndex(width);
+	ReadStorageBuffer(geometryBuffer, geometry.size()*sizeof(float), &geometry[0]);
+	ReadStorageBuffer(indexBuffer, gpuIndex.size()*sizeof(uint32_t), &gpuIndex[0]);
+
+	GLuint buffers[] = { geometryBuffer, sampleBuffer, configBuffer, timestampBuffer, indexBuffer };
+	glDeleteBuffers(5, buffers);
+
+	//Only uniformly spaced captures can skip uploading the timestamps
+	int errors = 0;
+	if( (config.dense != 0) != expectDense)
+	{
+		printf("%s: expected %s samples\n", name, expectDense ? "uniform" : "non-uniform");
+		errors ++;
+	}
+
+	//X coordinates are computed in double precision on both sides, so they (and the index) must match exactly.
+	//Y goes through single precision math, and log() on the GPU, so allow a little slop.
+	for(size_t i=0; i<count; i++)
+	{
+		if( (geometry[i*2] != xcoords[i]) || (fabs(geometry[i*2 + 1] - ycoords[i]) > 1e-3) )
+		{
+			if(errors < 10)
+			{
+				printf("%s: sample %zu: GPU (%f, %f), CPU (%f, %f)\n",
+					name, i, geometry[i*2], geometry[i*2 + 1], xcoords[i], ycoords[i]);
+			}
+			errors ++;
+		}
+	}
+	for(int i=0; i<width; i++)
+	{
+		if(gpuIndex[i] != index[i])
+		{
+			if(errors < 10)
+				printf("%s: column %d: GPU index %u, CPU index %u\n", name, i, gpuIndex[i], index[i]);
+			errors ++;
+		}
+	}
+
+	//The CPU path uploads an X/Y float pair per sample
+	double bytes = count*sizeof(float) + offsetBytes + sizeof(config);
+	printf("%-20s %-6s %5.2f bytes per sample (CPU path: %zu)\n",
+		name, errors ? "FAILED" : "OK", bytes / count, 2*sizeof(float));
+	return errors;
+}
+
+int main()
+{
+	if(!InitTestContext())
+	{
+		printf("No OpenGL 4.3 context available, skipping\n");
+		return TEST_SKIPPED;
+	}
+
+	g_transformProgram = LoadComputeProgram("waveform-transform-compute.glsl");
+	g_indexProgram = LoadComputeProgram("waveform-index-compute.glsl");
+	if(!g_transformProgram || !g_indexProgram)
+		return 1;
+
+	const int width = 1000;
+	WaveformTransformConfig config;
+	config.xscale			= 0.01;
+	config.xoff				= -37.5;
+	config.ybase			= 200;
+	config.pixelsPerVolt	= 150;
+	config.offset			= 0.25;
+	config.padding			= 2;
+	config.plotheight		= 396;
+	config.mode				= TRANSFORM_ANALOG;
+	config.memDepth			= 0;
+	config.tstart			= 0;
+	config.tstep			= 0;
+	config.dense			= 0;
+
+	int errors = 0;
+
+	//Uniformly sampled analog, hanging off both sides of the plot
+	AnalogCapture uniform;
+	for(size_t i=0; i<200000; i++)
+		uniform.m_samples.push_back(AnalogSample(i, 1, sin(i * 0.0007f)));
+	errors += CompareGeometry("analog", &uniform, config, width, true);
+
+	//Uniformly sampled, but not starting at zero or one unit apart
+	AnalogCapture strided;
+	for(size_t i=0; i<100000; i++)
+		strided.m_samples.push_back(AnalogSample(1000 + i*3, 3, sin(i * 0.002f)));
+	errors += CompareGeometry("analog strided", &strided, config, width, true);
+
+	//Irregularly sampled analog with gaps, and timestamps past 32 bits
+	AnalogCapture sparse;
+	int64_t t = 5000000000LL;
+	for(size_t i=0; i<50000; i++)
+	{
+		sparse.m_samples.push_back(AnalogSample(t, 1, cos(i * 0.01f) * 0.5f));
+		t += 1 + (i % 17) + ( (i % 1000) == 0 ? 20000 : 0);
+	}
+	WaveformTransformConfig sparseConfig = config;
+	sparseConfig.xoff = -5000000000LL * sparseConfig.xscale;
+	errors += CompareGeometry("analog sparse", &sparse, sparseConfig, width, false);
+
+	//Spectrum, plotted in dB
+	AnalogCapture spectrum;
+	for(size_t i=0; i<100000; i++)
+		spectrum.m_samples.push_back(AnalogSample(i, 1, 1e-4f + fabs(sin(i * 0.003f))));
+	WaveformTransformConfig fftConfig = config;
+	fftConfig.mode = TRANSFORM_FFT;
+	errors += CompareGeometry("spectrum", &spectrum, fftConfig, width, true);
+
+	//Digital, with irregular edges
+	DigitalCapture digital;
+	t = 0;
+	for(size_t i=0; i<20000; i++)
+	{
+		digital.m_samples.push_back(DigitalSample(t, 1, (i % 3) == 0));
+		t += 2 + (i % 5);
+	}
+	WaveformTransformConfig digitalConfig = config;
+	digitalConfig.mode = TRANSFORM_DIGITAL;
+	errors += CompareGeometry("digital", &digital, digitalConfig, width, false);
+
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,176 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Compares the CPU use of the old busy-polling main loop against sleeping on an eventfd
+
+	GTK isn't needed: poll() on an idle pipe stands in for the GTK event sources, with a zero timeout for
+	Gtk::Main::events_pending() and an infinite one for a blocking Gtk::Main::iteration(). Each loop runs once at idle
+	and once with a "scope thread" signaling 1000 waveforms per second.
+ */
+#include <stdio.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include "../SPSCQueue.h"
+
+using namespace std;
+
+static double GetTime()
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1E9;
+}
+
+static double GetThreadCPUTime()
+{
+	rusage usage;
+	getrusage(RUSAGE_THREAD, &usage);
+	return
+		usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 +
+		usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+}
+
+static const double RUN_TIME = 3;
+
+/**
+	@brief Runs one of the loops for RUN_TIME seconds and prints its CPU use
+
+	@param blocking	True for the new loop, false for the old one
+	@param rate		Waveforms per second from the fake scope thread, or zero for idle
+ */
+static void RunLoop(const char* name, bool blocking, double rate)
+{
+	//Start empty, the last run may have left something behind
+	static SPSCQueue<double, 8192> queue;
+	double stale;
+	while(queue.Pop(stale))
+	{}
+
+	int efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	int gtk[2];
+	if(pipe(gtk) != 0)
+		return;
+
+	//The fake scope thread
+	atomic<bool> done(false);
+	thread producer([&]
+	{
+		if(rate == 0)
+			return;
+		double next = GetTime();
+		while(!done)
+		{
+			next += 1 / rate;
+			double dt = next - GetTime();
+			if(dt > 0)
+				this_thread::sleep_for(chrono::duration<double>(dt));
+			queue.Push(GetTime());
+			uint64_t one = 1;
+			if(write(efd, &one, sizeof(one)) != sizeof(one))
+			{}
+		}
+	});
+
+	pollfd fds[2];
+	fds[0].fd = efd;
+	fds[0].events = POLLIN;
+	fds[1].fd = gtk[0];
+	fds[1].events = POLLIN;
+
+	double cpuStart = GetThreadCPUTime();
+	double start = GetTime();
+	double end = start + RUN_TIME;
+	double latency = 0;
+	double maxLatency = 0;
+	size_t count = 0;
+	while(true)
+	{
+		double now = GetTime();
+		if(now >= end)
+			break;
+
+		if(blocking)
+		{
+			//Gtk::Main::iteration(true), woken by the eventfd source
+			if(poll(fds, 2, (end - now) * 1000 + 1) > 0 && (fds[0].revents & POLLIN) )
+			{
+				uint64_t n;
+				if(read(efd, &n, sizeof(n)) != sizeof(n))
+				{}
+			}
+		}
+		else
+		{
+			//Gtk::Main::events_pending()
+			poll(fds, 2, 0);
+		}
+
+		//PollScopes()
+		double t;
+		while(queue.Pop(t))
+		{
+			double dt = GetTime() - t;
+			latency += dt;
+			maxLatency = max(maxLatency, dt);
+			count ++;
+		}
+	}
+	double cpu = GetThreadCPUTime() - cpuStart;
+	double wall = GetTime() - start;
+
+	done = true;
+	producer.join();
+	close(efd);
+	close(gtk[0]);
+	close(gtk[1]);
+
+	printf("%-10s %6.0f WFM/s  CPU %7.3f s in %.2f s (%5.1f%% of a core)",
+		name, rate, cpu, wall, cpu * 100 / wall);
+	if(count)
+		printf("  latency %6.1f us avg, %7.1f us max", latency * 1e6 / count, maxLatency * 1e6);
+	printf("\n");
+}
+
+int main()
+{
+	RunLoop("busy poll", false, 0);
+	RunLoop("eventfd", true, 0);
+	RunLoop("busy poll", false, 1000);
+	RunLoop("eventfd", true, 1000);
+	return 0;
+}
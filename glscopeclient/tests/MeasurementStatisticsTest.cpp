@@ -0,0 +1,202 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Tests for MeasurementStatistics: Welford's algorithm against a two-pass reference, and histogram doubling
+ */
+#include "../glscopeclient.h"
+#include "../MeasurementStatistics.h"
+
+using namespace std;
+
+static int g_errors = 0;
+
+#define CHECK(x) \
+	if(!(x)) \
+	{ \
+		printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #x); \
+		g_errors ++; \
+	}
+
+/**
+	@brief Checks the running statistics of a set of values against a two-pass calculation in long double
+ */
+static void CheckMoments(MeasurementStatistics& stats, const vector<double>& values)
+{
+	long double sum = 0;
+	for(auto x : values)
+		sum += x;
+	long double mean = sum / values.size();
+
+	long double sq = 0;
+	for(auto x : values)
+		sq += (x - mean) * (x - mean);
+	long double stdev = sqrtl(sq / (values.size() - 1));
+
+	CHECK(stats.GetCount() == values.size());
+	CHECK(stats.GetMin() == *min_element(values.begin(), values.end()));
+	CHECK(stats.GetMax() == *max_element(values.begin(), values.end()));
+	CHECK(fabsl(stats.GetMean() - mean) <= 1e-12 * fabsl(mean));
+	CHECK(fabsl(stats.GetStdDev() - stdev) <= 1e-6 * stdev);
+}
+
+/**
+	@brief Mean and variance stay accurate with a large offset and many samples, where summing squares would not
+ */
+static void TestWelford()
+{
+	srand(1);
+
+	//Small noise on a big DC offset, e.g. a period measurement in ps
+	MeasurementStatistics stats;
+	vector<double> values;
+	for(size_t i=0; i<1000000; i++)
+	{
+		double x = 1e9 + (rand() % 10000) * 1e-3;
+		values.push_back(x);
+		stats.Update(x);
+	}
+	CheckMoments(stats, values);
+
+	//Values that aren't finite are ignored
+	stats.Update(NAN);
+	stats.Update(INFINITY);
+	CheckMoments(stats, values);
+
+	//Reset starts over
+	stats.Reset();
+	CHECK(stats.GetCount() == 0);
+	CHECK(stats.GetStdDev() == 0);
+	values.clear();
+	for(size_t i=0; i<1000; i++)
+	{
+		double x = -5 + (rand() % 1000) * 1e-2;
+		values.push_back(x);
+		stats.Update(x);
+	}
+	CheckMoments(stats, values);
+}
+
+/**
+	@brief Checks that the histogram covers every value and each bin holds exactly the values in its range
+ */
+static void CheckHistogram(MeasurementStatistics& stats, const vector<double>& values)
+{
+	double low = stats.GetHistogramLow();
+	double width = stats.GetBinWidth();
+
+	size_t expected[MEASUREMENT_HISTOGRAM_BINS] = {0};
+	for(auto x : values)
+	{
+		CHECK(x >= low);
+		CHECK(x < low + width * MEASUREMENT_HISTOGRAM_BINS);
+		expected[static_cast<size_t>(floor((x - low) / width))] ++;
+	}
+
+	size_t total = 0;
+	for(size_t i=0; i<MEASUREMENT_HISTOGRAM_BINS; i++)
+	{
+		CHECK(stats.GetBinCount(i) == expected[i]);
+		total += stats.GetBinCount(i);
+	}
+	CHECK(total == values.size());
+}
+
+/**
+	@brief Walks the histogram through doubling in both directions. Integer values keep every bin edge exact.
+ */
+static void TestHistogram(bool firstBelow)
+{
+	MeasurementStatistics stats;
+	vector<double> values;
+
+	//Repeats of the first value all go in the first bin
+	for(size_t i=0; i<3; i++)
+	{
+		stats.Update(100);
+		values.push_back(100);
+	}
+	CHECK(stats.GetBinWidth() == 0);
+	CHECK(stats.GetBinCount(0) == 3);
+
+	//A second value sets the bin width so the two are half the histogram apart
+	double second = firstBelow ? 84 : 116;
+	stats.Update(second);
+	values.push_back(second);
+	CHECK(stats.GetBinWidth() == 1);
+	CheckHistogram(stats, values);
+
+	//One past the top doubles the range upwards
+	double top = stats.GetHistogramLow() + MEASUREMENT_HISTOGRAM_BINS;
+	stats.Update(top);
+	values.push_back(top);
+	CHECK(stats.GetBinWidth() == 2);
+	CheckHistogram(stats, values);
+
+	//Just below the bottom doubles it downwards
+	double bottom = stats.GetHistogramLow() - 1;
+	double oldLow = stats.GetHistogramLow();
+	stats.Update(bottom);
+	values.push_back(bottom);
+	CHECK(stats.GetBinWidth() == 4);
+	CHECK(stats.GetHistogramLow() == oldLow - 2 * MEASUREMENT_HISTOGRAM_BINS);
+	CheckHistogram(stats, values);
+
+	//Far outside doubles as many times as it takes, and nothing is lost
+	stats.Update(100000);
+	values.push_back(100000);
+	stats.Update(-100000);
+	values.push_back(-100000);
+	CheckHistogram(stats, values);
+
+	//Lots of random values inside the range
+	for(size_t i=0; i<10000; i++)
+	{
+		double x = (rand() % 200001) - 100000;
+		stats.Update(x);
+		values.push_back(x);
+	}
+	CheckHistogram(stats, values);
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+	TestWelford();
+	TestHistogram(false);
+	TestHistogram(true);
+
+	if(g_errors)
+	{
+		printf("%d checks failed\n", g_errors);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,146 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Tests for MinMaxPyramid level selection and decimation
+ */
+#include "../glscopeclient.h"
+#include "../MinMaxPyramid.h"
+
+using namespace std;
+
+static int g_errors = 0;
+
+#define CHECK(x) \
+	if(!(x)) \
+	{ \
+		printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #x); \
+		g_errors ++; \
+	}
+
+/**
+	@brief Makes sure every bucket of a level holds the min/max of its samples, and that no bucket wider than one
+	pixel overlaps the visible area
+ */
+static void VerifyLevel(AnalogCapture* cap, MinMaxPyramid& pyramid, size_t level, double xscale, double xoff, int width)
+{
+	if(level == 0)
+		return;
+
+	size_t depth = cap->GetDepth();
+	size_t bucketSize = 1 << level;
+	size_t buckets = pyramid.GetPointCount(level) / 2;
+	CHECK(buckets == (depth + bucketSize - 1) / bucketSize);
+
+	for(size_t b=0; b<buckets; b++)
+	{
+		size_t first = b * bucketSize;
+		size_t last = min(first + bucketSize, depth) - 1;
+
+		float vmin = (*cap)[first];
+		float vmax = vmin;
+		for(size_t i=first; i<=last; i++)
+		{
+			vmin = min(vmin, (float)(*cap)[i]);
+			vmax = max(vmax, (float)(*cap)[i]);
+		}
+
+		int64_t t;
+		float v;
+		pyramid.GetPoint(level, b*2, t, v);
+		CHECK(v == vmin);
+		pyramid.GetPoint(level, b*2 + 1, t, v);
+		CHECK(v == vmax);
+
+		//Buckets that are on screen must fit in one pixel
+		double xstart = cap->GetSampleStart(first) * xscale + xoff;
+		double xend = cap->GetSampleStart(last) * xscale + xoff;
+		if( (xend >= 0) && (xstart <= width) )
+			CHECK(xend - xstart <= 1);
+	}
+}
+
+int main()
+{
+	const int width = 1000;
+
+	//Uniformly sampled, 1M points across the whole plot: 1000 samples per pixel
+	AnalogCapture uniform;
+	for(size_t i=0; i<1000000; i++)
+		uniform.m_samples.push_back(AnalogSample(i, 1, sin(i * 0.001f) + (i % 97) * 0.01f));
+
+	MinMaxPyramid pyramid;
+	double xscale = 0.001;
+	size_t level = pyramid.SelectLevel(&uniform, xscale, 0, width);
+	CHECK(level == 9);
+	VerifyLevel(&uniform, pyramid, level, xscale, 0, width);
+
+	//Zoomed in to a few samples per pixel, raw data has to be drawn
+	CHECK(pyramid.SelectLevel(&uniform, 2, 0, width) == 0);
+
+	//Non-uniform: a dense burst of 1M samples one unit apart, followed by 100 sparse ones 1M units apart
+	AnalogCapture sparse;
+	int64_t t = 0;
+	for(size_t i=0; i<1000100; i++)
+	{
+		sparse.m_samples.push_back(AnalogSample(t, 1, (i % 13) * 0.1f));
+		t += (i < 1000000) ? 1 : 1000000;
+	}
+
+	//Zoomed out over the whole thing, the average is ~1000 samples per pixel, but the sparse samples are
+	//~10 pixels apart and can't be merged into buckets
+	MinMaxPyramid pyramid2;
+	xscale = (double)width / t;
+	level = pyramid2.SelectLevel(&sparse, xscale, 0, width);
+	CHECK(level == 0);
+
+	//Looking only at the dense burst, decimating is fine
+	xscale = 0.002;
+	level = pyramid2.SelectLevel(&sparse, xscale, 0, width);
+	CHECK(level == 8);
+	VerifyLevel(&sparse, pyramid2, level, xscale, 0, width);
+
+	//Scrolled over to the sparse part, the pyramid must not be used
+	level = pyramid2.SelectLevel(&sparse, xscale, -2E7 * xscale, width);
+	CHECK(level == 0);
+
+	//Different capture means the pyramid is rebuilt
+	level = pyramid2.SelectLevel(&uniform, 0.001, 0, width);
+	CHECK(level == 9);
+	VerifyLevel(&uniform, pyramid2, level, 0.001, 0, width);
+
+	if(g_errors)
+	{
+		printf("%d checks failed\n", g_errors);
+		return 1;
+	}
+	return 0;
+}
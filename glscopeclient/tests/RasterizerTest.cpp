@@ -0,0 +1,253 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Checks waveform-compute.glsl against the CPU reference rasterizer.
+
+	Run with LIBGL_ALWAYS_SOFTWARE=1 to test under Mesa's software rasterizer.
+ */
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+#include "../ColumnIndex.h"
+#include "GLTestContext.h"
+#include "ReferenceRasterizer.h"
+
+using namespace std;
+
+//Must match the shader
+#define COLS_PER_BLOCK	2
+#define TILE_HEIGHT		1024
+
+static GLuint g_program;
+
+/**
+	@brief A set of waveforms to draw in one pass, and the texture to draw them into
+ */
+class RasterTest
+{
+public:
+	RasterTest(const char* name, size_t width, size_t height, size_t layers)
+	: m_name(name)
+	, m_width(width)
+	, m_height(height)
+	, m_layers(layers)
+	, m_image(width * height * layers, 0)
+	{
+		m_config.windowHeight = height;
+		m_config.windowWidth = width;
+		m_config.numWaveforms = 0;
+		m_config.persistDecay = 0;
+	}
+
+	/**
+		@brief Adds a waveform, building its column index the same way WaveformArea::GenerateGeometry does
+	 */
+	void AddWaveform(const vector<float>& xy, uint32_t weight, uint32_t layer)
+	{
+		WaveformDescriptor desc;
+		desc.offset = m_geometry.size() / 2;
+		desc.depth = xy.size() / 2;
+		desc.indexOffset = m_index.size();
+		desc.weight = weight;
+		desc.layer = layer;
+		m_waveforms.push_back(desc);
+		m_config.numWaveforms = m_waveforms.size();
+
+		m_geometry.insert(m_geometry.end(), xy.begin(), xy.end());
+
+		vector<float> xcoords(desc.depth);
+		for(size_t i=0; i<desc.depth; i++)
+			xcoords[i] = xy[i*2];
+		for(size_t i=0; i<m_width; i++)
+			m_index.push_back(BinarySearchForGequal(&xcoords[0], desc.depth, i));
+	}
+
+	int Run();
+
+	const char* m_name;
+	size_t m_width;
+	size_t m_height;
+	size_t m_layers;
+	WaveformRenderConfig m_config;
+	vector<float> m_geometry;
+	vector<uint32_t> m_index;
+	vector<WaveformDescriptor> m_waveforms;
+
+	//Initial texture contents, for testing persistence
+	vector<float> m_image;
+};
+
+/**
+	@brief Rasterizes the waveforms on the GPU, the same way WaveformArea::RenderTrace does, and on the CPU
+
+	@return Number of mismatched pixels
+ */
+int RasterTest::Run()
+{
+	//GPU
+	GLuint tex;
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32F, m_width, m_height, m_layers, 0, GL_RED, GL_FLOAT, &m_image[0]);
+
+	GLuint geometryBuffer = CreateStorageBuffer(m_geometry.size()*sizeof(float), &m_geometry[0]);
+	GLuint configBuffer = CreateStorageBuffer(sizeof(m_config), &m_config);
+	GLuint indexBuffer = CreateStorageBuffer(m_index.size()*sizeof(uint32_t), &m_index[0]);
+	GLuint descriptorBuffer = CreateStorageBuffer(m_waveforms.size()*sizeof(WaveformDescriptor), &m_waveforms[0]);
+
+	glUseProgram(g_program);
+	glBindImageTexture(0, tex, 0, GL_TRUE, 0, GL_READ_WRITE, GL_R32F);
+	glUniform1i(glGetUniformLocation(g_program, "outputTex"), 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, geometryBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, configBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, indexBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, descriptorBuffer);
+	size_t numCols = (m_config.windowWidth + COLS_PER_BLOCK - 1) / COLS_PER_BLOCK * COLS_PER_BLOCK;
+	glDispatchCompute(numCols / COLS_PER_BLOCK, (m_height + TILE_HEIGHT - 1) / TILE_HEIGHT, m_layers);
+	glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+	vector<float> gpu(m_image.size());
+	glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_RED, GL_FLOAT, &gpu[0]);
+
+	GLuint buffers[] = { geometryBuffer, configBuffer, indexBuffer, descriptorBuffer };
+	glDeleteBuffers(4, buffers);
+	glDeleteTextures(1, &tex);
+
+	//CPU
+	vector<float> ref = m_image;
+	ReferenceRasterize(
+		&m_geometry[0], &m_index[0], &m_waveforms[0], m_config, m_width, m_height, m_layers, &ref[0]);
+
+	//Accumulation is exact, only the persistence decay can round differently
+	int errors = 0;
+	size_t hits = 0;
+	for(size_t i=0; i<ref.size(); i++)
+	{
+		if(ref[i] > 0)
+			hits ++;
+		if(fabs(gpu[i] - ref[i]) > 1e-5 * max(1.0f, fabs(ref[i])))
+		{
+			if(errors < 10)
+			{
+				size_t x = i % m_width;
+				size_t y = (i / m_width) % m_height;
+				size_t layer = i / (m_width * m_height);
+				printf("%s: pixel (%zu, %zu, %zu): GPU %f, CPU %f\n", m_name, x, y, layer, gpu[i], ref[i]);
+			}
+			errors ++;
+		}
+	}
+
+	printf("%-24s %8zu pixels drawn  %s\n", m_name, hits, errors ? "FAILED" : "OK");
+	return errors;
+}
+
+/**
+	@brief Random walk across the whole plot, with occasional large jumps
+ */
+static vector<float> RandomWalk(size_t depth, float width, float ymid, float yrange)
+{
+	vector<float> xy(depth * 2);
+	float y = ymid;
+	for(size_t i=0; i<depth; i++)
+	{
+		y += (rand() % 1000 - 500) * yrange / 20000;
+		if( (rand() % 500) == 0)
+			y = ymid + (rand() % 1000 - 500) * yrange / 1000;
+		xy[i*2] = i * width / depth;
+		xy[i*2 + 1] = y;
+	}
+	return xy;
+}
+
+int main()
+{
+	if(!InitTestContext())
+	{
+		printf("No OpenGL 4.3 context available, skipping\n");
+		return TEST_SKIPPED;
+	}
+
+	g_program = LoadComputeProgram("waveform-compute.glsl");
+	if(!g_program)
+		return 1;
+
+	srand(1);
+	int errors = 0;
+
+	//Deep capture in a view taller than one tile, with an odd plot width narrower than the texture
+	{
+		RasterTest test("deep, 3 tiles", 700, 2500, 1);
+		test.m_config.windowWidth = 651;
+		test.AddWaveform(RandomWalk(500000, 700, 1250, 2400), 256, 0);
+		errors += test.Run();
+	}
+
+	//Sparse samples with long segments, some points off every edge of the plot
+	{
+		RasterTest test("sparse, clipped", 512, 300, 1);
+		vector<float> xy;
+		for(int i=0; i<40; i++)
+		{
+			xy.push_back(-30 + i * 15.3f);
+			xy.push_back( (i % 2) ? -50 : 350 + (i % 7) * 3.5f);
+		}
+		test.AddWaveform(xy, 256, 0);
+		errors += test.Run();
+	}
+
+	//Several overlays batched into a texture with a layer each, like WaveformArea::PrepareOverlayGeometry
+	{
+		RasterTest test("layered overlays", 400, 300, 2);
+		test.AddWaveform(RandomWalk(10000, 400, 80, 100), 128, 0);
+		test.AddWaveform(RandomWalk(3000, 400, 200, 50), 200, 1);
+		test.AddWaveform(RandomWalk(20000, 400, 150, 250), 64, 1);
+		errors += test.Run();
+	}
+
+	//Persistence batch: several waveforms with decaying weights on top of the decayed old contents
+	{
+		RasterTest test("persistence batch", 300, 200, 1);
+		for(size_t i=0; i<test.m_image.size(); i++)
+			test.m_image[i] = (i % 13) * 0.37f;
+		float weight = 256;
+		for(int i=0; i<4; i++)
+		{
+			test.AddWaveform(RandomWalk(5000, 300, 100, 150), lround(weight), 0);
+			weight *= 0.9f;
+		}
+		test.m_config.persistDecay = pow(0.9f, 4);
+		errors += test.Run();
+	}
+
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,128 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  CPU reference for waveform-compute.glsl, for checking the shader's output
+ */
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "ReferenceRasterizer.h"
+
+using namespace std;
+
+//Must match the shader
+#define COLS_PER_BLOCK	2
+
+/**
+	@brief Does exactly what waveform-compute.glsl does, one column at a time.
+
+	The shader splits each column's segments across threads and the window height into tiles, but every segment
+	adds to each pixel it covers with integer atomics, so the result doesn't depend on how the work is divided.
+	The same float math and fixed point accumulation are used here, so results should match bit for bit.
+
+	@param geometry		Interleaved X/Y pixel coordinates of every sample
+	@param index		Column index of every waveform
+	@param waveforms	config.numWaveforms descriptors
+	@param config		Global configuration block
+	@param texWidth		Width of the output texture
+	@param texHeight	Height of the output texture
+	@param layers		Number of layers in the output texture
+	@param image		Output texture contents (layers * texHeight * texWidth floats, row major), updated in place
+ */
+void ReferenceRasterize(
+	const float* geometry,
+	const uint32_t* index,
+	const WaveformDescriptor* waveforms,
+	const WaveformRenderConfig& config,
+	size_t texWidth,
+	size_t texHeight,
+	size_t layers,
+	float* image)
+{
+	//Columns are dispatched in whole blocks, but nothing right of the plot is drawn
+	size_t numCols = (config.windowWidth + COLS_PER_BLOCK - 1) / COLS_PER_BLOCK * COLS_PER_BLOCK;
+	numCols = min(min(numCols, (size_t)config.windowWidth + 1), texWidth);
+	size_t height = min((size_t)config.windowHeight, texHeight);
+
+	vector<uint32_t> column(height);
+	for(size_t layer=0; layer<layers; layer++)
+	{
+		for(size_t col=0; col<numCols; col++)
+		{
+			fill(column.begin(), column.end(), 0);
+
+			for(uint32_t w=0; w<config.numWaveforms; w++)
+			{
+				auto& wfm = waveforms[w];
+				if( (wfm.depth < 2) || (wfm.layer != layer) )
+					continue;
+
+				const float* data = geometry + wfm.offset*2;
+				float fcol = float(col);
+				for(uint32_t i=index[wfm.indexOffset + col]; i<(wfm.depth-1); i++)
+				{
+					float leftx = data[i*2];
+					float lefty = data[i*2 + 1];
+					float rightx = data[i*2 + 2];
+					float righty = data[i*2 + 3];
+
+					if(leftx > fcol + 1)
+						break;
+					if(rightx < fcol)
+						continue;
+
+					float starty = lefty;
+					float endy = righty;
+					float slope = (righty - lefty) / (rightx - leftx);
+					if(leftx < fcol)
+						starty = lefty + ( (fcol - leftx) * slope );
+					if(rightx > fcol + 1)
+						endy = lefty + ( (fcol + 1 - leftx) * slope );
+
+					int ymin = max((int)min(starty, endy), 0);
+					int ymax = min((int)max(starty, endy), (int)height - 1);
+					for(int y=ymin; y<=ymax; y++)
+						column[y] += wfm.weight;
+				}
+			}
+
+			for(size_t y=0; y<height; y++)
+			{
+				float& pixel = image[(layer*texHeight + y)*texWidth + col];
+				float alpha = float(column[y]) / 256;
+				if(config.persistDecay > 0)
+					alpha += pixel * config.persistDecay;
+				pixel = alpha;
+			}
+		}
+	}
+}
@@ -0,0 +1,198 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Compares SPSCQueue against a mutex-protected deque, like the scope's own pending waveform queue
+
+	One thread pushes a sequence of numbers and another pops them, checking they come out in order, as fast as they
+	can go for throughput. Then timestamped WaveformTokens are pushed at a fixed rate for the push-to-pop latency.
+ */
+#include <stdio.h>
+#include <time.h>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Oscilloscope;
+#include "../ScopePoller.h"
+
+using namespace std;
+
+static double GetTime()
+{
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1E9;
+}
+
+/**
+	@brief Baseline: the same interface with a lock around a deque
+ */
+template<class T, size_t N>
+class LockedQueue
+{
+public:
+	bool Push(const T& item)
+	{
+		lock_guard<mutex> lock(m_mutex);
+		if(m_data.size() == N)
+			return false;
+		m_data.push_back(item);
+		return true;
+	}
+
+	bool Pop(T& item)
+	{
+		lock_guard<mutex> lock(m_mutex);
+		if(m_data.empty())
+			return false;
+		item = m_data.front();
+		m_data.pop_front();
+		return true;
+	}
+
+protected:
+	mutex m_mutex;
+	deque<T> m_data;
+};
+
+/**
+	@brief Runs count items through a queue
+
+	@return Number of items that came out of order
+ */
+template<class Q>
+static size_t RunQueue(const char* name, Q& queue, size_t count)
+{
+	double start = GetTime();
+
+	thread producer([&queue, count]
+	{
+		for(size_t i=0; i<count; i++)
+		{
+			while(!queue.Push(i))
+				this_thread::yield();
+		}
+	});
+
+	size_t errors = 0;
+	for(size_t i=0; i<count; i++)
+	{
+		size_t item;
+		while(!queue.Pop(item))
+			this_thread::yield();
+		if(item != i)
+			errors ++;
+	}
+	producer.join();
+
+	double dt = GetTime() - start;
+	printf("%-16s %8.2f Mitems/s saturated\n", name, count / dt * 1e-6);
+	return errors;
+}
+
+/**
+	@brief Pushes timestamped tokens at a fixed rate, like a scope thread at a high trigger rate, and prints how long
+	each one took to come out of the other end
+ */
+template<class Q>
+static void RunPaced(const char* name, Q& queue, double rate)
+{
+	size_t count = rate * 2;
+	vector<double> latencies;
+	latencies.reserve(count);
+
+	thread producer([&queue, rate, count]
+	{
+		double next = GetTime();
+		for(size_t i=0; i<count; i++)
+		{
+			next += 1 / rate;
+			while(GetTime() < next)
+				this_thread::yield();
+
+			WaveformToken token = { GetTime() };
+			while(!queue.Push(token))
+				this_thread::yield();
+		}
+	});
+
+	for(size_t i=0; i<count; i++)
+	{
+		WaveformToken token;
+		while(!queue.Pop(token))
+			this_thread::yield();
+		latencies.push_back(GetTime() - token.m_tAcquired);
+	}
+	producer.join();
+
+	sort(latencies.begin(), latencies.end());
+	double sum = 0;
+	for(auto t : latencies)
+		sum += t;
+	printf("%-16s %7.0f WFM/s  latency %7.2f us avg, %8.2f us p99, %9.2f us max\n",
+		name,
+		rate,
+		sum * 1e6 / count,
+		latencies[count * 99 / 100] * 1e6,
+		latencies.back() * 1e6);
+}
+
+int main()
+{
+	const size_t count = 20 * 1000 * 1000;
+
+	//Same size as WaveformQueue
+	static SPSCQueue<size_t, 8192> spsc;
+	static LockedQueue<size_t, 8192> locked;
+
+	size_t errors = 0;
+	errors += RunQueue("mutex + deque", locked, count);
+	errors += RunQueue("SPSCQueue", spsc, count);
+
+	//Latency at realistic waveform rates
+	static WaveformQueue spscTokens;
+	static LockedQueue<WaveformToken, 8192> lockedTokens;
+	for(double rate : {10000.0, 100000.0})
+	{
+		RunPaced("mutex + deque", lockedTokens, rate);
+		RunPaced("SPSCQueue", spscTokens, rate);
+	}
+
+	if(errors)
+	{
+		printf("%zu items out of order\n", errors);
+		return 1;
+	}
+	return 0;
+}
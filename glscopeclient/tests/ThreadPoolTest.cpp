@@ -0,0 +1,170 @@
+/***********************************************************************************************************************
+*                                                                                                                      *
+* ANTIKERNEL v0.1                                                                                                      *
+*                                                                                                                      *
+* Copyright (c) 2012-2020 Andrew D. Zonenberg                                                                          *
+* All rights reserved.                                                                                                 *
+*                                                                                                                      *
+* Redistribution and use in source and binary forms, with or without modification, are permitted provided that the     *
+* following conditions are met:                                                                                        *
+*                                                                                                                      *
+*    * Redistributions of source code must retain the above copyright notice, this list of conditions, and the         *
+*      following disclaimer.                                                                                           *
+*                                                                                                                      *
+*    * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the       *
+*      following disclaimer in the documentation and/or other materials provided with the distribution.                *
+*                                                                                                                      *
+*    * Neither the name of the author nor the names of any contributors may be used to endorse or promote products     *
+*      derived from this software without specific prior written permission.                                           *
+*                                                                                                                      *
+* THIS SOFTWARE IS PROVIDED BY THE AUTHORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED   *
+* TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL *
+* THE AUTHORS BE HELD LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES        *
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR       *
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT *
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE       *
+* POSSIBILITY OF SUCH DAMAGE.                                                                                          *
+*                                                                                                                      *
+***********************************************************************************************************************/
+
+/**
+	@file
+	@author Andrew D. Zonenberg
+	@brief  Tests for ThreadPool: every task runs, tasks can submit more tasks, and exceptions don't kill workers
+ */
+#include "../glscopeclient.h"
+#include "../ThreadPool.h"
+
+using namespace std;
+
+static int g_errors = 0;
+
+#define CHECK(x) \
+	if(!(x)) \
+	{ \
+		printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #x); \
+		g_errors ++; \
+	}
+
+/**
+	@brief Counts finished tasks and lets the test wait for a given number of them
+ */
+class Completion
+{
+public:
+	Completion()
+	: m_done(0)
+	{}
+
+	void Done()
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_done ++;
+		m_cond.notify_all();
+	}
+
+	bool WaitFor(size_t count)
+	{
+		unique_lock<mutex> lock(m_mutex);
+		return m_cond.wait_for(lock, chrono::seconds(30), [this, count]{ return m_done >= count; });
+	}
+
+	mutex m_mutex;
+	condition_variable m_cond;
+	size_t m_done;
+};
+
+/**
+	@brief Lots of small tasks from outside the pool
+ */
+static void TestExternalSubmit(ThreadPool& pool)
+{
+	const size_t count = 100000;
+	Completion done;
+	atomic<size_t> sum(0);
+	for(size_t i=0; i<count; i++)
+	{
+		pool.Submit([&done, &sum, i]
+		{
+			sum += i;
+			done.Done();
+		});
+	}
+	CHECK(done.WaitFor(count));
+	CHECK(sum == count * (count-1) / 2);
+}
+
+/**
+	@brief A tree of tasks, each submitting its children from a worker
+ */
+static void Spawn(ThreadPool& pool, Completion& done, size_t depth)
+{
+	if(depth > 0)
+	{
+		for(int i=0; i<4; i++)
+			pool.Submit([&pool, &done, depth]{ Spawn(pool, done, depth-1); });
+	}
+	done.Done();
+}
+
+static void TestNestedSubmit(ThreadPool& pool)
+{
+	//1 + 4 + 16 + ... + 4^8 tasks
+	const size_t depth = 8;
+	size_t count = 0;
+	for(size_t d=0, n=1; d<=depth; d++, n*=4)
+		count += n;
+
+	Completion done;
+	pool.Submit([&pool, &done]{ Spawn(pool, done, depth); });
+	CHECK(done.WaitFor(count));
+}
+
+/**
+	@brief Tasks that throw must not take their worker down
+ */
+static void TestExceptions(ThreadPool& pool)
+{
+	size_t count = pool.GetThreadCount() * 4;
+	for(size_t i=0; i<count; i++)
+		pool.Submit([]{ throw runtime_error("expected test exception"); });
+
+	//Every worker is still around to run these
+	Completion done;
+	for(size_t i=0; i<count; i++)
+		pool.Submit([&done]{ done.Done(); });
+	CHECK(done.WaitFor(count));
+}
+
+/**
+	@brief Everything submitted before the pool is destroyed still runs
+ */
+static void TestShutdown()
+{
+	atomic<size_t> ran(0);
+	{
+		ThreadPool pool(4);
+		for(size_t i=0; i<1000; i++)
+			pool.Submit([&ran]{ ran ++; });
+	}
+	CHECK(ran == 1000);
+}
+
+int main()
+{
+	for(size_t threads : {1, 2, 8})
+	{
+		ThreadPool pool(threads);
+		TestExternalSubmit(pool);
+		TestNestedSubmit(pool);
+		TestExceptions(pool);
+	}
+	TestShutdown();
+
+	if(g_errors)
+	{
+		printf("%d checks failed\n", g_errors);
+		return 1;
+	}
+	return 0;
+}